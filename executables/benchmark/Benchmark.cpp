@@ -0,0 +1,538 @@
+#include "Benchmark.hpp"
+
+#include "BedrockAssert.hpp"
+#include "BedrockLog.hpp"
+#include "ForwardKinematic.hpp"
+#include "ForwardKinematicSoA.hpp"
+#include "JobSystem.hpp"
+#include "ParallelSolver.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using namespace Shared;
+
+//======================================================================================================================
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    using Method = InverseKinematic::Method;
+    using DampingMode = InverseKinematic::DampingMode;
+    using LinearSolver = InverseKinematic::LinearSolver;
+    using JacobianMode = InverseKinematic::JacobianMode;
+
+    struct SolverVariant
+    {
+        char const * name;
+        Method method = Method::DampedLeastSquares;
+        DampingMode dampingMode = DampingMode::Adaptive;
+        LinearSolver linearSolver = LinearSolver::TaskSpace;
+        JacobianMode jacobianMode = JacobianMode::Analytic;
+        bool useSpecializedSolvers = false;     // TwoBoneSolver and FixedChainSolver routing
+    };
+
+    // The first one is the default configuration of the visualization and the one of the workers phase
+    SolverVariant const SolverVariants[] {
+        {.name = "dls_task_space"},
+        {.name = "dls_joint_space", .linearSolver = LinearSolver::JointSpace},
+        {.name = "dls_selective", .dampingMode = DampingMode::Selective},
+        {.name = "dls_dual", .jacobianMode = JacobianMode::Dual},
+        {.name = "dls_specialized", .useSpecializedSolvers = true},
+        {.name = "fabrik", .method = Method::FABRIK},
+        {.name = "ccd", .method = Method::CCD},
+    };
+
+    [[nodiscard]]
+    InverseKinematic::Params SolverParams(SolverVariant const & variant, int const maxIterations, float const tolerance)
+    {
+        InverseKinematic::Params params{};
+        params.method = variant.method;
+        params.dampingMode = variant.dampingMode;
+        params.linearSolver = variant.linearSolver;
+        params.jacobianMode = variant.jacobianMode;
+        params.useTwoBoneSolver = variant.useSpecializedSolvers;
+        params.useFixedChainSolvers = variant.useSpecializedSolvers;
+        params.maxIterations = maxIterations;
+        params.tolerance = tolerance;
+        return params;
+    }
+
+    // Written by every timed operation so the compiler cannot drop the work
+    volatile float Sink = 0.0f;
+
+    void Consume(float const value)
+    {
+        Sink = Sink + value;
+    }
+
+    void Consume(glm::vec3 const & value)
+    {
+        Sink = Sink + value.x + value.y + value.z;
+    }
+
+    // True for a joint space variant on a chain longer than maxJointSpaceJoints, which is skipped
+    [[nodiscard]]
+    bool ExceedsJointSpaceLimit(SolverVariant const & variant, int const jointCount, int const maxJointSpaceJoints)
+    {
+        return variant.method == Method::DampedLeastSquares && variant.linearSolver == LinearSolver::JointSpace &&
+            jointCount > maxJointSpaceJoints;
+    }
+
+    // Json has no inf or nan, a broken measurement is written as null instead of an invalid document
+    void WriteNumber(FILE * output, char const * key, double const value)
+    {
+        if (std::isfinite(value) == true)
+        {
+            fprintf(output, ", \"%s\": %.4f", key, value);
+        }
+        else
+        {
+            fprintf(output, ", \"%s\": null", key);
+        }
+    }
+}
+
+//======================================================================================================================
+
+Benchmark::Benchmark(Params const & params)
+    : _params(params)
+    , _random(params.seed)
+{
+    MFA_ASSERT(_params.sampleCount > 0);
+    MFA_ASSERT(_params.solveSampleCount > 0);
+    _params.sampleCount = std::max(_params.sampleCount, 1);
+    _params.solveSampleCount = std::max(_params.solveSampleCount, 1);
+
+    if (_params.workerCounts.empty() == true)
+    {
+        int const hardwareThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        for (int workerCount = 1; workerCount < hardwareThreads; workerCount *= 2)
+        {
+            _params.workerCounts.emplace_back(workerCount);
+        }
+        _params.workerCounts.emplace_back(hardwareThreads);
+    }
+}
+
+//======================================================================================================================
+
+void Benchmark::Run()
+{
+    for (auto const jointCount : _params.jointCounts)
+    {
+        MFA_ASSERT(jointCount > 0);
+        if (jointCount <= 0)
+        {
+            continue;
+        }
+        if (_params.runForwardKinematic == true)
+        {
+            RunForwardKinematic(jointCount);
+        }
+        if (_params.runJacobian == true)
+        {
+            RunJacobian(jointCount);
+        }
+        if (_params.runLinearSolve == true)
+        {
+            RunLinearSolve(jointCount);
+        }
+        if (_params.runSolve == true)
+        {
+            RunSolve(jointCount);
+        }
+        if (_params.runWorkers == true)
+        {
+            RunWorkers(jointCount);
+        }
+    }
+}
+
+//======================================================================================================================
+
+std::vector<Benchmark::Record> const & Benchmark::GetRecords() const
+{
+    return _records;
+}
+
+//======================================================================================================================
+
+void Benchmark::WriteJson(FILE * output) const
+{
+    auto const * jobSystem = MFA::JobSystem::Instance;
+    fprintf(output, "{\n  \"meta\": {");
+    fprintf(output, "\"hardwareThreads\": %u", std::thread::hardware_concurrency());
+    fprintf(
+        output,
+        ", \"jobSystemThreads\": %d",
+        jobSystem != nullptr ? static_cast<int>(jobSystem->NumberOfAvailableThreads()) : 0
+    );
+    fprintf(
+        output,
+        ", \"forwardKinematicKernel\": \"%s\"",
+        ForwardKinematicSoA::KernelName(ForwardKinematicSoA::ActiveKernel())
+    );
+#ifdef NDEBUG
+    fprintf(output, ", \"build\": \"release\"");
+#else
+    fprintf(output, ", \"build\": \"debug\"");
+#endif
+    fprintf(output, ", \"sampleCount\": %d", _params.sampleCount);
+    fprintf(output, ", \"solveSampleCount\": %d", _params.solveSampleCount);
+    fprintf(output, ", \"maxIterations\": %d", _params.maxIterations);
+    WriteNumber(output, "tolerance", _params.tolerance);
+    fprintf(output, ", \"seed\": %u, \"unit\": \"us\"},\n  \"results\": [", _params.seed);
+
+    for (size_t i = 0; i < _records.size(); i++)
+    {
+        auto const & record = _records[i];
+        fprintf(
+            output,
+            "%s\n    {\"phase\": \"%s\", \"variant\": \"%s\", \"joints\": %d, \"workers\": %d, \"samples\": %d",
+            i == 0 ? "" : ",",
+            record.phase.c_str(),
+            record.variant.c_str(),
+            record.jointCount,
+            record.workerCount,
+            record.sampleCount
+        );
+        WriteNumber(output, "min", record.min);
+        WriteNumber(output, "mean", record.mean);
+        WriteNumber(output, "p50", record.p50);
+        WriteNumber(output, "p90", record.p90);
+        WriteNumber(output, "p99", record.p99);
+        WriteNumber(output, "max", record.max);
+        if (record.meanIterations >= 0.0)
+        {
+            WriteNumber(output, "meanIterations", record.meanIterations);
+        }
+        if (record.convergedRate >= 0.0)
+        {
+            WriteNumber(output, "convergedRate", record.convergedRate);
+        }
+        if (record.solvesPerSecond >= 0.0)
+        {
+            WriteNumber(output, "solvesPerSecond", record.solvesPerSecond);
+        }
+        if (record.isJacobianValid.has_value() == true)
+        {
+            fprintf(output, ", \"jacobianValid\": %s", *record.isJacobianValid == true ? "true" : "false");
+        }
+        fputc('}', output);
+    }
+    fprintf(output, "\n  ]\n}\n");
+}
+
+//======================================================================================================================
+
+template<typename Operation>
+Benchmark::Record Benchmark::Measure(
+    char const * phase,
+    char const * variant,
+    int const jointCount,
+    int const sampleCount,
+    Operation const & operation,
+    int const operationsPerCall
+)
+{
+    // The first call warms the caches and tells how many calls fit in a sample
+    auto const calibrationStart = Clock::now();
+    operation();
+    auto const calibrationUs = std::chrono::duration<double, std::micro>(Clock::now() - calibrationStart).count();
+    int const repetitions = std::clamp(
+        static_cast<int>(_params.sampleDurationUs / std::max(calibrationUs, 1e-3)),
+        1,
+        100000
+    );
+
+    std::vector<double> samples(sampleCount);
+    for (auto & sample : samples)
+    {
+        auto const start = Clock::now();
+        for (int i = 0; i < repetitions; i++)
+        {
+            operation();
+        }
+        auto const elapsedUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        sample = elapsedUs / static_cast<double>(repetitions * operationsPerCall);
+    }
+
+    Record record{};
+    record.phase = phase;
+    record.variant = variant;
+    record.jointCount = jointCount;
+    record.sampleCount = sampleCount;
+
+    // Nearest rank percentiles
+    std::sort(samples.begin(), samples.end());
+    auto const percentile = [&samples](double const fraction)->double
+    {
+        auto const rank = static_cast<int>(std::ceil(fraction * static_cast<double>(samples.size())));
+        return samples[std::clamp(rank - 1, 0, static_cast<int>(samples.size()) - 1)];
+    };
+    record.min = samples.front();
+    record.max = samples.back();
+    record.p50 = percentile(0.5);
+    record.p90 = percentile(0.9);
+    record.p99 = percentile(0.99);
+    double sum = 0.0;
+    for (auto const sample : samples)
+    {
+        sum += sample;
+    }
+    record.mean = sum / static_cast<double>(samples.size());
+
+    return record;
+}
+
+//======================================================================================================================
+
+void Benchmark::RunForwardKinematic(int const jointCount)
+{
+    // Two poses of the same chain so every call changes every joint
+    Chain const poses[2] {MakeChain(jointCount, 30.0f), MakeChain(jointCount, 30.0f)};
+
+    KinematicChain kinematicChain{poses[0]};
+    int poseIdx = 0;
+    AddRecord(Measure("forward_kinematic", "kinematic_chain", jointCount, _params.sampleCount, [&]()->void
+    {
+        poseIdx ^= 1;
+        auto const & pose = poses[poseIdx];
+        for (int i = 0; i < jointCount; i++)
+        {
+            kinematicChain.SetJoint(i, pose[i]);
+        }
+        kinematicChain.Update();
+        Consume(kinematicChain.EndPoint());
+    }));
+
+    std::vector<glm::mat4> matrices(jointCount);
+    AddRecord(Measure("forward_kinematic", "matrices", jointCount, _params.sampleCount, [&]()->void
+    {
+        Consume(ForwardKinematic::Calculate(poses[0].data(), jointCount, matrices.data()));
+    }));
+
+    // A batch of chains, reported per chain
+    static constexpr int SoA_ChainCount = 64;
+    ChainSoA chains{jointCount, SoA_ChainCount};
+    for (int i = 0; i < SoA_ChainCount; i++)
+    {
+        chains.SetChain(i, poses[i & 1]);
+    }
+    ForwardKinematicSoA::PointsSoA endPoints{};
+    for (auto const kernel : {
+        ForwardKinematicSoA::KernelType::Scalar,
+        ForwardKinematicSoA::KernelType::AVX2,
+        ForwardKinematicSoA::KernelType::NEON
+    })
+    {
+        if (ForwardKinematicSoA::IsSupported(kernel) == false)
+        {
+            continue;
+        }
+        auto const variant = std::string("soa_") + ForwardKinematicSoA::KernelName(kernel);
+        AddRecord(Measure("forward_kinematic", variant.c_str(), jointCount, _params.sampleCount, [&]()->void
+        {
+            ForwardKinematicSoA::Calculate(chains, endPoints, nullptr, kernel);
+            Consume(endPoints.Get(0));
+        }, SoA_ChainCount));
+    }
+}
+
+//======================================================================================================================
+
+void Benchmark::RunJacobian(int const jointCount)
+{
+    KinematicChain kinematicChain{MakeChain(jointCount, 30.0f)};
+    kinematicChain.Update();
+    Eigen::MatrixX<float> J{};
+
+    // A fast jacobian that disagrees with the others is a bug, not a result
+    bool const isValid = InverseKinematic::ValidateJacobian(kinematicChain.GetJoints());
+    if (isValid == false)
+    {
+        MFA_LOG_ERROR("Analytic, dual and finite difference jacobians of %d joints do not match", jointCount);
+    }
+
+    auto analytic = Measure("jacobian", "analytic", jointCount, _params.sampleCount, [&]()->void
+    {
+        InverseKinematic::AnalyticJacobian(kinematicChain, J);
+        Consume(J(0, 0));
+    });
+    auto dual = Measure("jacobian", "dual", jointCount, _params.sampleCount, [&]()->void
+    {
+        InverseKinematic::DualJacobian(kinematicChain, J);
+        Consume(J(0, 0));
+    });
+    auto finiteDifference = Measure("jacobian", "finite_difference", jointCount, _params.sampleCount, [&]()->void
+    {
+        InverseKinematic::Jacobian(kinematicChain, J);
+        Consume(J(0, 0));
+    });
+    for (auto * record : {&analytic, &dual, &finiteDifference})
+    {
+        record->isJacobianValid = isValid;
+        AddRecord(*record);
+    }
+}
+
+//======================================================================================================================
+
+void Benchmark::RunLinearSolve(int const jointCount)
+{
+    auto const chain = MakeChain(jointCount, 30.0f);
+    glm::vec3 const error {0.1f, -0.2f, 0.3f};
+
+    for (auto const & variant : SolverVariants)
+    {
+        // Every damped least squares variant with its own linear solve, the jacobian mode does not change it
+        if (variant.method != Method::DampedLeastSquares || variant.jacobianMode != JacobianMode::Analytic ||
+            variant.useSpecializedSolvers == true ||
+            ExceedsJointSpaceLimit(variant, jointCount, _params.maxJointSpaceJoints) == true)
+        {
+            continue;
+        }
+
+        InverseKinematic const solver{SolverParams(variant, _params.maxIterations, _params.tolerance)};
+
+        InverseKinematic::Workspace workspace{};
+        workspace.chain.Assign(chain);
+        workspace.chain.Update();
+        InverseKinematic::AnalyticJacobian(workspace.chain, workspace.J);
+
+        AddRecord(Measure("linear_solve", variant.name, jointCount, _params.sampleCount, [&]()->void
+        {
+            solver.CalculatePositionStep(error, workspace);
+            Consume(workspace.dTheta[0]);
+        }));
+    }
+}
+
+//======================================================================================================================
+
+void Benchmark::RunSolve(int const jointCount)
+{
+    // Slightly bent so the start is not the singular straight pose
+    auto const chain = MakeChain(jointCount, 10.0f);
+    auto const targets = MakeTargets(chain, _params.solveSampleCount);
+
+    for (auto const & variant : SolverVariants)
+    {
+        if (ExceedsJointSpaceLimit(variant, jointCount, _params.maxJointSpaceJoints) == true)
+        {
+            continue;
+        }
+
+        InverseKinematic const solver{SolverParams(variant, _params.maxIterations, _params.tolerance)};
+
+        InverseKinematic::Workspace workspace{};
+        Chain scratch{};
+        size_t solveCount = 0;
+        uint64_t iterationSum = 0;
+        uint64_t convergedCount = 0;
+
+        auto record = Measure("solve", variant.name, jointCount, _params.solveSampleCount, [&]()->void
+        {
+            scratch = chain;
+            auto const result = solver.Solve(scratch, targets[solveCount % targets.size()], workspace);
+            solveCount++;
+            iterationSum += result.iterations;
+            convergedCount += result.converged == true ? 1 : 0;
+        });
+        record.meanIterations = static_cast<double>(iterationSum) / static_cast<double>(solveCount);
+        record.convergedRate = static_cast<double>(convergedCount) / static_cast<double>(solveCount);
+        record.solvesPerSecond = record.mean > 0.0 ? 1e6 / record.mean : 0.0;
+        AddRecord(record);
+    }
+}
+
+//======================================================================================================================
+
+void Benchmark::RunWorkers(int const jointCount)
+{
+    auto const & variant = SolverVariants[0];
+
+    // Large enough to keep every worker busy, small enough that long chains finish a sample in a fraction of a second
+    int const largestWorkerCount = *std::max_element(_params.workerCounts.begin(), _params.workerCounts.end());
+    int const batchSize = std::max(std::clamp(16384 / jointCount, 16, 1024), largestWorkerCount * 4);
+
+    auto const chain = MakeChain(jointCount, 10.0f);
+    auto const targets = MakeTargets(chain, batchSize);
+    ParallelSolver parallelSolver{SolverParams(variant, _params.maxIterations, _params.tolerance), 1};
+    std::vector<Chain> chains{};
+    std::vector<InverseKinematic::Result> results{};
+
+    for (auto const workerCount : _params.workerCounts)
+    {
+        parallelSolver.SetWorkerCount(workerCount);
+        auto record = Measure(
+            "workers",
+            variant.name,
+            jointCount,
+            _params.solveSampleCount,
+            [&]()->void
+            {
+                chains.assign(batchSize, chain);
+                parallelSolver.Solve(chains, targets, results).get();
+            },
+            batchSize
+        );
+        record.workerCount = workerCount;
+        record.solvesPerSecond = record.mean > 0.0 ? 1e6 / record.mean : 0.0;
+        AddRecord(record);
+    }
+}
+
+//======================================================================================================================
+
+void Benchmark::AddRecord(Record const & record)
+{
+    MFA_LOG_INFO(
+        "%s %s: %d joints, %d workers, p50 %.3f us, p99 %.3f us",
+        record.phase.c_str(),
+        record.variant.c_str(),
+        record.jointCount,
+        record.workerCount,
+        record.p50,
+        record.p99
+    );
+    _records.emplace_back(record);
+}
+
+//======================================================================================================================
+
+Chain Benchmark::MakeChain(int const jointCount, float const angleSpread)
+{
+    std::uniform_real_distribution<float> angle(-angleSpread, angleSpread);
+    Chain chain(jointCount);
+    for (auto & joint : chain)
+    {
+        joint.length = 10.0f / static_cast<float>(jointCount);
+        joint.angle = glm::vec2{angle(_random), angle(_random)};
+    }
+    return chain;
+}
+
+//======================================================================================================================
+
+std::vector<glm::vec3> Benchmark::MakeTargets(Chain const & chain, int const count)
+{
+    std::uniform_real_distribution<float> angle(-60.0f, 60.0f);
+    std::vector<glm::vec3> targets(count);
+    Chain pose = chain;
+    for (auto & target : targets)
+    {
+        for (auto & joint : pose)
+        {
+            joint.angle = glm::vec2{angle(_random), angle(_random)};
+        }
+        target = ForwardKinematic::Calculate(pose);
+    }
+    return targets;
+}
+
+//======================================================================================================================
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "InverseKinematic.hpp"
+
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+// Times the parts of the solver hot path on their own (forward kinematic, jacobian, linear solve) and whole solves,
+// for every chain length, solver variant and worker count of the params. Every measurement is a list of samples of
+// which the percentiles are reported, so a regression of the tail shows up as well as one of the median.
+//
+// Phases and their variants:
+//   forward_kinematic   kinematic_chain (SetJoint on every joint and Update), matrices (ForwardKinematic::Calculate),
+//                       soa_<kernel> (ForwardKinematicSoA, time per chain)
+//   jacobian            analytic, dual, finite_difference, each marked with the result of
+//                       InverseKinematic::ValidateJacobian on the chain
+//   linear_solve        One damped least squares step from a ready jacobian: dls_task_space, dls_joint_space,
+//                       dls_selective
+//   solve               Whole solves from the same start toward reachable targets: dls_task_space, dls_joint_space,
+//                       dls_selective, dls_dual, dls_specialized (two bone and fixed chain solvers allowed), fabrik,
+//                       ccd
+//   workers             ParallelSolver batches of dls_task_space solves, time per solve
+class Benchmark
+{
+public:
+
+    struct Params
+    {
+        std::vector<int> jointCounts {2, 4, 8, 16, 32, 64, 128, 256, 512, 1000};
+        std::vector<int> workerCounts{};    // Empty means 1, 2, 4 ... up to the hardware thread count
+        int sampleCount = 100;              // Forward kinematic, jacobian and linear solve samples
+        int solveSampleCount = 30;          // Whole solve and batch samples, these take up to milliseconds each
+        // The joint space solve factors a (3n x 3n) matrix, longer chains would dominate the run time
+        int maxJointSpaceJoints = 64;
+        float sampleDurationUs = 50.0f;     // Fast operations are repeated until a sample takes about this long
+        int maxIterations = 100;            // Of the whole solves
+        float tolerance = 1e-3f;
+        uint32_t seed = 1;
+        bool runForwardKinematic = true;
+        bool runJacobian = true;
+        bool runLinearSolve = true;
+        bool runSolve = true;
+        bool runWorkers = true;
+    };
+
+    struct Record
+    {
+        std::string phase{};
+        std::string variant{};
+        int jointCount {};
+        int workerCount = 1;
+        int sampleCount {};
+        // Microseconds per operation
+        double min {};
+        double mean {};
+        double p50 {};
+        double p90 {};
+        double p99 {};
+        double max {};
+        // Whole solves only, negative when not measured
+        double meanIterations = -1.0;
+        double convergedRate = -1.0;
+        double solvesPerSecond = -1.0;
+        // Jacobian records only, whether InverseKinematic::ValidateJacobian accepted the chain
+        std::optional<bool> isJacobianValid{};
+    };
+
+    explicit Benchmark(Params const & params);
+
+    // Runs every enabled phase for every joint count, progress is logged as the records come in
+    void Run();
+
+    [[nodiscard]]
+    std::vector<Record> const & GetRecords() const;
+
+    void WriteJson(FILE * output) const;
+
+private:
+
+    // Times sampleCount samples of the operation. Operations shorter than sampleDurationUs are repeated within a
+    // sample, operationsPerCall divides the time of a call for batched operations.
+    template<typename Operation>
+    Record Measure(
+        char const * phase,
+        char const * variant,
+        int jointCount,
+        int sampleCount,
+        Operation const & operation,
+        int operationsPerCall = 1
+    );
+
+    void RunForwardKinematic(int jointCount);
+
+    void RunJacobian(int jointCount);
+
+    void RunLinearSolve(int jointCount);
+
+    void RunSolve(int jointCount);
+
+    void RunWorkers(int jointCount);
+
+    void AddRecord(Record const & record);
+
+    // Chain of jointCount joints with free angles within angleSpread degree and a total length of 10
+    [[nodiscard]]
+    Shared::Chain MakeChain(int jointCount, float angleSpread);
+
+    // End points of random poses of the chain, so every target is reachable
+    [[nodiscard]]
+    std::vector<glm::vec3> MakeTargets(Shared::Chain const & chain, int count);
+
+    Params _params{};
+    std::minstd_rand _random{};
+    std::vector<Record> _records{};
+
+};
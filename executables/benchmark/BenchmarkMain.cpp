@@ -0,0 +1,181 @@
+#include "Benchmark.hpp"
+
+#include "JobSystem.hpp"
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace
+{
+    void PrintUsage()
+    {
+        fputs(
+            "Usage: Benchmark [options]\n"
+            "  --output <path>          Json report, benchmark.json by default\n"
+            "  --lengths <n,n,...>      Joint counts, 2,4,8,16,32,64,128,256,512,1000 by default\n"
+            "  --workers <n,n,...>      Worker counts of the workers phase, 1,2,4 ... hardware threads by default\n"
+            "  --phases <name,...>      Any of forward_kinematic,jacobian,linear_solve,solve,workers, all by default\n"
+            "  --samples <n>            Samples of forward_kinematic, jacobian and linear_solve, 100 by default\n"
+            "  --solve-samples <n>      Samples of solve and workers, 30 by default\n"
+            "  --max-joint-space <n>    Longest chain the joint space solver runs on, 64 by default\n"
+            "  --iterations <n>         Iterations per solve, 100 by default\n"
+            "  --tolerance <value>      Distance at which a solve counts as converged, 0.001 by default\n"
+            "  --seed <n>               Seed of the chains and targets, 1 by default\n",
+            stderr
+        );
+    }
+
+    // Parses a comma separated list of positive integers
+    bool ParseList(char const * text, std::vector<int> & outValues)
+    {
+        outValues.clear();
+        std::string_view list{text};
+        while (list.empty() == false)
+        {
+            auto const end = std::min(list.find(','), list.size());
+            int const value = std::atoi(std::string(list.substr(0, end)).c_str());
+            if (value <= 0)
+            {
+                return false;
+            }
+            outValues.emplace_back(value);
+            list.remove_prefix(std::min(end + 1, list.size()));
+        }
+        return outValues.empty() == false;
+    }
+
+    bool ParsePhases(char const * text, Benchmark::Params & params)
+    {
+        params.runForwardKinematic = false;
+        params.runJacobian = false;
+        params.runLinearSolve = false;
+        params.runSolve = false;
+        params.runWorkers = false;
+
+        std::string_view list{text};
+        while (list.empty() == false)
+        {
+            auto const end = std::min(list.find(','), list.size());
+            auto const phase = list.substr(0, end);
+            if (phase == "forward_kinematic")
+            {
+                params.runForwardKinematic = true;
+            }
+            else if (phase == "jacobian")
+            {
+                params.runJacobian = true;
+            }
+            else if (phase == "linear_solve")
+            {
+                params.runLinearSolve = true;
+            }
+            else if (phase == "solve")
+            {
+                params.runSolve = true;
+            }
+            else if (phase == "workers")
+            {
+                params.runWorkers = true;
+            }
+            else
+            {
+                return false;
+            }
+            list.remove_prefix(std::min(end + 1, list.size()));
+        }
+        return true;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    Benchmark::Params params{};
+    std::string outputPath = "benchmark.json";
+
+    for (int i = 1; i < argc; i++)
+    {
+        auto const hasValue = i + 1 < argc;
+        bool isValid = hasValue;
+        if (std::strcmp(argv[i], "--output") == 0 && hasValue)
+        {
+            outputPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--lengths") == 0 && hasValue)
+        {
+            isValid = ParseList(argv[++i], params.jointCounts);
+        }
+        else if (std::strcmp(argv[i], "--workers") == 0 && hasValue)
+        {
+            isValid = ParseList(argv[++i], params.workerCounts);
+        }
+        else if (std::strcmp(argv[i], "--phases") == 0 && hasValue)
+        {
+            isValid = ParsePhases(argv[++i], params);
+        }
+        else if (std::strcmp(argv[i], "--samples") == 0 && hasValue)
+        {
+            params.sampleCount = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (std::strcmp(argv[i], "--solve-samples") == 0 && hasValue)
+        {
+            params.solveSampleCount = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (std::strcmp(argv[i], "--max-joint-space") == 0 && hasValue)
+        {
+            params.maxJointSpaceJoints = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--iterations") == 0 && hasValue)
+        {
+            params.maxIterations = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (std::strcmp(argv[i], "--tolerance") == 0 && hasValue)
+        {
+            params.tolerance = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && hasValue)
+        {
+            params.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            isValid = false;
+        }
+
+        if (isValid == false)
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    // Opened before the run so a wrong path fails right away
+    FILE * output = fopen(outputPath.c_str(), "wb");
+    if (output == nullptr)
+    {
+        fprintf(stderr, "Cannot open %s\n", outputPath.c_str());
+        return 1;
+    }
+
+    auto jobSystem = MFA::JobSystem::Instantiate();
+
+    Benchmark benchmark{params};
+    benchmark.Run();
+
+    // Pending library logs go out before the summary
+    fflush(stdout);
+    benchmark.WriteJson(output);
+    fclose(output);
+
+    fprintf(stderr, "Wrote %zu records to %s\n", benchmark.GetRecords().size(), outputPath.c_str());
+
+    for (auto const & record : benchmark.GetRecords())
+    {
+        if (record.isJacobianValid == false)
+        {
+            fprintf(stderr, "Jacobian validation failed for %d joints\n", record.jointCount);
+            return 2;
+        }
+    }
+    return 0;
+}
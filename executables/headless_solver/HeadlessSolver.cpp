@@ -0,0 +1,308 @@
+#include "HeadlessSolver.hpp"
+
+#include "BedrockAssert.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <string>
+
+using namespace Shared;
+
+//======================================================================================================================
+
+namespace
+{
+    // Splits the line on spaces and tabs, returns the number of tokens written
+    int Tokenize(std::string_view line, std::string_view * outTokens, int const maxTokens)
+    {
+        int count = 0;
+        size_t position = 0;
+        while (position < line.size())
+        {
+            position = line.find_first_not_of(" \t\r", position);
+            if (position == std::string_view::npos)
+            {
+                break;
+            }
+            auto end = line.find_first_of(" \t\r", position);
+            if (end == std::string_view::npos)
+            {
+                end = line.size();
+            }
+            if (count == maxTokens)
+            {
+                return maxTokens + 1;
+            }
+            outTokens[count++] = line.substr(position, end - position);
+            position = end;
+        }
+        return count;
+    }
+
+    template<typename T>
+    bool Parse(std::string_view const token, T & outValue)
+    {
+        auto const [end, error] = std::from_chars(token.data(), token.data() + token.size(), outValue);
+        return error == std::errc{} && end == token.data() + token.size();
+    }
+}
+
+//======================================================================================================================
+
+HeadlessSolver::HeadlessSolver(Params const & params)
+    : _params(params)
+    , _solver(params.solverParams)
+{
+    MFA_ASSERT(_params.chunkSize > 0);
+    _params.chunkSize = std::max(_params.chunkSize, 1);
+
+    if (_params.warmStart == false)
+    {
+        _parallelSolver = std::make_unique<ParallelSolver>(_params.solverParams, _params.workerCount);
+    }
+
+    _pendingChains.resize(_params.chunkSize);
+    _chains.resize(_params.chunkSize);
+    _targets.resize(_params.chunkSize);
+    _results.resize(_params.chunkSize);
+}
+
+//======================================================================================================================
+
+bool HeadlessSolver::Run(std::istream & input, FILE * output)
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+
+    if (_params.outputFormat == OutputFormat::CSV)
+    {
+        fputs("target,chain,converged,iterations,error,joints\n", output);
+    }
+
+    bool isValid = true;
+    std::string line{};
+    uint64_t lineNumber = 0;
+    while (std::getline(input, line))
+    {
+        lineNumber++;
+        if (ParseLine(line, lineNumber) == false)
+        {
+            isValid = false;
+            break;
+        }
+        if (_pendingCount == _params.chunkSize)
+        {
+            SolveChunk(output);
+        }
+    }
+
+    // The last chunk is usually partial, the buffers are shrunk so the solver sees only the pending targets
+    if (_pendingCount > 0)
+    {
+        _pendingChains.resize(_pendingCount);
+        _chains.resize(_pendingCount);
+        _targets.resize(_pendingCount);
+        _results.resize(_pendingCount);
+        SolveChunk(output);
+    }
+    fflush(output);
+
+    auto const end = std::chrono::high_resolution_clock::now();
+    _statistics.totalSeconds = std::chrono::duration<double>(end - start).count();
+    return isValid;
+}
+
+//======================================================================================================================
+
+HeadlessSolver::Statistics const & HeadlessSolver::GetStatistics() const
+{
+    return _statistics;
+}
+
+//======================================================================================================================
+
+bool HeadlessSolver::ParseLine(std::string_view line, uint64_t const lineNumber)
+{
+    line = line.substr(0, line.find('#'));
+
+    static constexpr int MaxTokens = 11;
+    std::string_view tokens[MaxTokens] {};
+    int const tokenCount = Tokenize(line, tokens, MaxTokens);
+    if (tokenCount == 0)
+    {
+        return true;
+    }
+
+    auto const reportError = [&](char const * message)->bool
+    {
+        fprintf(stderr, "Line %llu: %s\n", static_cast<unsigned long long>(lineNumber), message);
+        return false;
+    };
+
+    auto const & keyword = tokens[0];
+    if (keyword == "chain")
+    {
+        if (tokenCount != 1)
+        {
+            return reportError("chain takes no arguments");
+        }
+        _definitions.emplace_back();
+        return true;
+    }
+
+    if (keyword == "joint")
+    {
+        if (_definitions.empty() == true)
+        {
+            return reportError("joint before the first chain");
+        }
+        if (tokenCount != 5 && tokenCount != 11)
+        {
+            return reportError("joint expects <length> <x> <y> <free DOF mask> and optionally 6 limits");
+        }
+
+        Joint joint{};
+        int freeMask {};
+        if (Parse(tokens[1], joint.length) == false ||
+            Parse(tokens[2], joint.angle.x) == false ||
+            Parse(tokens[3], joint.angle.y) == false ||
+            Parse(tokens[4], freeMask) == false)
+        {
+            return reportError("joint has a malformed number");
+        }
+        joint.isLengthFixed = (freeMask & LengthBit) == 0;
+        joint.isX_AngleFixed = (freeMask & X_AngleBit) == 0;
+        joint.isY_AngleFixed = (freeMask & Y_AngleBit) == 0;
+
+        if (tokenCount == 11)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                if (Parse(tokens[5 + i], joint.minLimit[i]) == false ||
+                    Parse(tokens[8 + i], joint.maxLimit[i]) == false)
+                {
+                    return reportError("joint has a malformed limit");
+                }
+            }
+        }
+
+        _definitions.back().emplace_back(joint);
+        return true;
+    }
+
+    if (keyword == "target")
+    {
+        uint32_t chainIdx {};
+        glm::vec3 position {};
+        if (tokenCount != 5 ||
+            Parse(tokens[1], chainIdx) == false ||
+            Parse(tokens[2], position.x) == false ||
+            Parse(tokens[3], position.y) == false ||
+            Parse(tokens[4], position.z) == false)
+        {
+            return reportError("target expects <chain> <x> <y> <z>");
+        }
+        if (chainIdx >= _definitions.size() || _definitions[chainIdx].empty() == true)
+        {
+            return reportError("target refers to an undefined or empty chain");
+        }
+
+        // Copy assignment keeps the capacity of the slot, so a chunk allocates nothing once the buffers have grown
+        _pendingChains[_pendingCount] = chainIdx;
+        _chains[_pendingCount] = _definitions[chainIdx];
+        _targets[_pendingCount] = position;
+        _pendingCount++;
+        return true;
+    }
+
+    return reportError("unknown statement, expected chain, joint or target");
+}
+
+//======================================================================================================================
+
+void HeadlessSolver::SolveChunk(FILE * output)
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+
+    if (_params.warmStart == true)
+    {
+        for (int i = 0; i < _pendingCount; i++)
+        {
+            _results[i] = _cache.Solve(_solver, _pendingChains[i], _chains[i], _targets[i]);
+        }
+    }
+    else
+    {
+        _parallelSolver->Solve(_chains, _targets, _results).get();
+    }
+
+    auto const end = std::chrono::high_resolution_clock::now();
+    _statistics.solveSeconds += std::chrono::duration<double>(end - start).count();
+    _statistics.chunkCount++;
+
+    WriteChunk(output);
+    _pendingCount = 0;
+}
+
+//======================================================================================================================
+
+void HeadlessSolver::WriteChunk(FILE * output)
+{
+    for (int i = 0; i < _pendingCount; i++)
+    {
+        auto const & result = _results[i];
+        auto const & chain = _chains[i];
+        auto const targetIdx = _nextTarget++;
+
+        _statistics.solveCount++;
+        _statistics.convergedCount += result.converged == true ? 1 : 0;
+
+        if (_params.outputFormat == OutputFormat::Binary)
+        {
+            BinaryRecord const record {
+                .target = targetIdx,
+                .chain = _pendingChains[i],
+                .converged = result.converged == true ? 1u : 0u,
+                .iterations = static_cast<uint32_t>(result.iterations),
+                .error = result.error,
+                .jointCount = static_cast<uint32_t>(chain.size()),
+            };
+            fwrite(&record, sizeof(record), 1, output);
+            for (auto const & joint : chain)
+            {
+                float const values[DOF_PerJoint] {joint.length, joint.angle.x, joint.angle.y};
+                fwrite(values, sizeof(values), 1, output);
+            }
+            continue;
+        }
+
+        // Numbers are formatted into a reused string so a record is a single write
+        char buffer[64];
+        _text.clear();
+        auto const append = [&](auto const value)->void
+        {
+            auto const [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            MFA_ASSERT(error == std::errc{});
+            _text.append(buffer, end);
+        };
+        append(targetIdx);
+        _text += ',';
+        append(_pendingChains[i]);
+        _text += result.converged == true ? ",1," : ",0,";
+        append(result.iterations);
+        _text += ',';
+        append(result.error);
+        for (auto const & joint : chain)
+        {
+            _text += ',';
+            append(joint.length);
+            _text += ',';
+            append(joint.angle.x);
+            _text += ',';
+            append(joint.angle.y);
+        }
+        _text += '\n';
+        fwrite(_text.data(), 1, _text.size(), output);
+    }
+}
+
+//======================================================================================================================
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "InverseKinematic.hpp"
+#include "ParallelSolver.hpp"
+#include "SolutionCache.hpp"
+
+#include <cstdio>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Reads chain definitions and targets from a text stream and writes the solved joint values, without any renderer.
+// Targets are buffered in chunks of a fixed size, every chunk is solved and written before the next one is read, so
+// the memory use does not depend on the length of the stream.
+//
+// Input, one statement per line, # starts a comment:
+//   chain                                      Starts a new chain, chains are numbered from 0 in order
+//   joint <length> <x angle> <y angle> <free DOF mask> [<min length> <min x> <min y> <max length> <max x> <max y>]
+//                                              Appends a joint to the last chain. The mask uses DOF_Bit (1 length,
+//                                              2 x angle, 4 y angle), angles are in degree
+//   target <chain> <x> <y> <z>                 Solves the chain toward the position
+//
+// Output, one record per target in input order:
+//   CSV     target,chain,converged,iterations,error followed by length,x angle,y angle of every joint
+//   Binary  BinaryRecord followed by jointCount * 3 floats (length, x angle, y angle of every joint)
+class HeadlessSolver
+{
+public:
+
+    enum class OutputFormat
+    {
+        CSV,
+        Binary,
+    };
+
+    struct Params
+    {
+        Shared::InverseKinematic::Params solverParams{};
+        OutputFormat outputFormat = OutputFormat::CSV;
+        int chunkSize = 4096;           // Targets buffered before they are solved
+        int workerCount = 0;            // <= 0 means one worker per job system thread
+        // Every target of a chain starts from the last converged pose of that chain instead of its definition.
+        // The solves of a chain depend on each other then, so the chunk is solved on the calling thread.
+        bool warmStart = false;
+    };
+
+    struct BinaryRecord
+    {
+        uint32_t target {};
+        uint32_t chain {};
+        uint32_t converged {};
+        uint32_t iterations {};
+        float error {};
+        uint32_t jointCount {};
+    };
+
+    struct Statistics
+    {
+        uint64_t solveCount {};
+        uint64_t convergedCount {};
+        uint64_t chunkCount {};
+        double solveSeconds {};         // Time spent in the solver only
+        double totalSeconds {};         // Including parsing and writing
+    };
+
+    explicit HeadlessSolver(Params const & params);
+
+    // Processes the whole input. Returns false and reports the line on stderr if the input is malformed, the chunks
+    // before that line are already written.
+    [[nodiscard]]
+    bool Run(std::istream & input, FILE * output);
+
+    [[nodiscard]]
+    Statistics const & GetStatistics() const;
+
+private:
+
+    [[nodiscard]]
+    bool ParseLine(std::string_view line, uint64_t lineNumber);
+
+    void SolveChunk(FILE * output);
+
+    void WriteChunk(FILE * output);
+
+    Params _params{};
+    Shared::InverseKinematic _solver;
+    std::unique_ptr<Shared::ParallelSolver> _parallelSolver{};
+    Shared::SolutionCache _cache{};
+
+    std::vector<Shared::Chain> _definitions{};
+
+    // Chunk buffers, reused between chunks
+    int _pendingCount {};
+    std::vector<uint32_t> _pendingChains{};
+    std::vector<Shared::Chain> _chains{};
+    std::vector<glm::vec3> _targets{};
+    std::vector<Shared::InverseKinematic::Result> _results{};
+    std::string _text{};
+
+    uint32_t _nextTarget {};
+    Statistics _statistics{};
+
+};
@@ -0,0 +1,171 @@
+#include "HeadlessSolver.hpp"
+
+#include "JobSystem.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#define dup _dup
+#define dup2 _dup2
+#define fileno _fileno
+#define fdopen _fdopen
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    void PrintUsage()
+    {
+        fputs(
+            "Usage: HeadlessSolver [options]\n"
+            "  --input <path>       Read chains and targets from the file instead of stdin\n"
+            "  --output <path>      Write the results to the file instead of stdout\n"
+            "  --format csv|binary  Output format, csv by default\n"
+            "  --chunk-size <n>     Targets solved per chunk, 4096 by default\n"
+            "  --workers <n>        Solver workers, one per job system thread by default\n"
+            "  --iterations <n>     Iterations per solve, 64 by default\n"
+            "  --tolerance <value>  Distance at which a solve counts as converged, 0.001 by default\n"
+            "  --warm-start         Start every target from the last converged pose of its chain\n",
+            stderr
+        );
+    }
+
+    // Library logs are printed to stdout. When the results go to stdout as well they get a descriptor of their own
+    // and stdout is pointed at stderr, so no log line ends up in the data.
+    FILE * TakeStdoutForData()
+    {
+        fflush(stdout);
+        int const dataDescriptor = dup(fileno(stdout));
+        dup2(fileno(stderr), fileno(stdout));
+        FILE * data = fdopen(dataDescriptor, "wb");
+#ifdef _WIN32
+        _setmode(dataDescriptor, _O_BINARY);
+#endif
+        return data;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    HeadlessSolver::Params params{};
+    params.solverParams.maxIterations = 64;
+    params.solverParams.tolerance = 1e-3f;
+
+    std::string inputPath{};
+    std::string outputPath{};
+
+    for (int i = 1; i < argc; i++)
+    {
+        auto const hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--input") == 0 && hasValue)
+        {
+            inputPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && hasValue)
+        {
+            outputPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--format") == 0 && hasValue)
+        {
+            std::string const format = argv[++i];
+            if (format == "csv")
+            {
+                params.outputFormat = HeadlessSolver::OutputFormat::CSV;
+            }
+            else if (format == "binary")
+            {
+                params.outputFormat = HeadlessSolver::OutputFormat::Binary;
+            }
+            else
+            {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--chunk-size") == 0 && hasValue)
+        {
+            params.chunkSize = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (std::strcmp(argv[i], "--workers") == 0 && hasValue)
+        {
+            params.workerCount = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--iterations") == 0 && hasValue)
+        {
+            params.solverParams.maxIterations = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (std::strcmp(argv[i], "--tolerance") == 0 && hasValue)
+        {
+            params.solverParams.tolerance = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--warm-start") == 0)
+        {
+            params.warmStart = true;
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    std::ifstream inputFile{};
+    if (inputPath.empty() == false)
+    {
+        inputFile.open(inputPath);
+        if (inputFile.is_open() == false)
+        {
+            fprintf(stderr, "Cannot open %s\n", inputPath.c_str());
+            return 1;
+        }
+    }
+    std::istream & input = inputPath.empty() == false ? inputFile : std::cin;
+    std::ios::sync_with_stdio(false);
+
+    FILE * output = outputPath.empty() == false ? fopen(outputPath.c_str(), "wb") : TakeStdoutForData();
+    if (output == nullptr)
+    {
+        fprintf(stderr, "Cannot open %s\n", outputPath.empty() == false ? outputPath.c_str() : "stdout");
+        return 1;
+    }
+    setvbuf(output, nullptr, _IOFBF, 1 << 20);
+
+    auto jobSystem = MFA::JobSystem::Instantiate();
+    if (params.workerCount <= 0)
+    {
+        params.workerCount = std::max(static_cast<int>(jobSystem->NumberOfAvailableThreads()), 1);
+    }
+
+    bool isValid = false;
+    {
+        HeadlessSolver solver{params};
+        isValid = solver.Run(input, output);
+
+        // Pending library logs go out before the report
+        fflush(stdout);
+        auto const & statistics = solver.GetStatistics();
+        fprintf(
+            stderr,
+            "Solved %llu targets (%llu converged) in %llu chunks with %d workers\n"
+            "Solver: %.3f seconds, %.0f solves/sec\n"
+            "Total: %.3f seconds, %.0f solves/sec\n",
+            static_cast<unsigned long long>(statistics.solveCount),
+            static_cast<unsigned long long>(statistics.convergedCount),
+            static_cast<unsigned long long>(statistics.chunkCount),
+            params.warmStart == true ? 1 : params.workerCount,
+            statistics.solveSeconds,
+            statistics.solveSeconds > 0.0 ? static_cast<double>(statistics.solveCount) / statistics.solveSeconds : 0.0,
+            statistics.totalSeconds,
+            statistics.totalSeconds > 0.0 ? static_cast<double>(statistics.solveCount) / statistics.totalSeconds : 0.0
+        );
+    }
+
+    fclose(output);
+    return isValid == true ? 0 : 1;
+}
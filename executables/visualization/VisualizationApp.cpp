@@ -142,6 +142,8 @@ VisualizationApp::VisualizationApp()
         _camera->SetnearPlane(0.010f);
         _camera->SetmaxDistance(100.0f);
     }
+
+    _ik = std::make_unique<Shared::InverseKinematic>(Shared::InverseKinematic::Params{.damping = _damping});
 }
 
 //======================================================================================================================
@@ -229,39 +231,19 @@ void VisualizationApp::Update(float deltaTime)
 
     if (_ikEnabled == true && _hierarchy.empty() == false)
     {
-        // Calculate IK here
-        glm::vec3 const currentEndPoint = CalculateJointsLocation();
-        Eigen::MatrixX<float> const J = Jacobian(currentEndPoint);
-        Eigen::MatrixX<float> const JT = Eigen::Transpose(J);
-        auto const dEGlm = _ikTargetPosition - currentEndPoint;
-        Eigen::MatrixX<float> dE (3, 1);
-        dE(0, 0) = dEGlm[0]; dE(1, 0) = dEGlm[1]; dE(2, 0) = dEGlm[2];
-        // TODO: Add damping
-        Eigen::MatrixX<float> const JTxJ = (JT * J);
-        Eigen::MatrixX<float> const identity = Eigen::MatrixXf::Identity(JTxJ.rows(), JTxJ.cols());
-        Eigen::MatrixX<float> const damping = _damping * identity;
-        Eigen::MatrixX<float> const dTheta = Eigen::Inverse(JTxJ + damping) * JT * dE;
-        for (int i = 0; i < (int)_hierarchy.size(); i++)
-        {
-            auto & joint = _hierarchy[i];
-            if (joint.isLengthFixed == false)
-            {
-                joint.length = joint.length + dTheta(i * 3 + 0, 0);
-            }
-            if (joint.isX_AngleFixed == false)
-            {
-                joint.angle.x = joint.angle.x + dTheta(i * 3 + 1, 0);
-            }
-            if (joint.isY_AngleFixed == false)
-            {
-                joint.angle.y = joint.angle.y + dTheta(i * 3 + 2, 0);
-            }
-        }
-        // MFA_LOG_INFO("dTheta.rows(): %d, dTheta.cols(): %d", dTheta.rows(), dTheta.cols());
-        // for (int i = 0; i < dTheta.rows(); i++)
-        // {
-        //     printf("%f\n", dTheta(i, 0));
-        // }
+        auto params = _ik->GetParams();
+        params.method = _ikMethod;
+        params.damping = _damping;
+        params.dampingMode = _dampingMode;
+        params.jacobianMode = _jacobianMode;
+        params.linearSolver = _linearSolver;
+        params.useTwoBoneSolver = _useTwoBoneSolver;
+        params.twoBonePole = _useTwoBonePole == true ? std::optional<glm::vec3>{_twoBonePole} : std::nullopt;
+        params.maxIterations = _ikMaxIterations;
+        params.tolerance = _ikTolerance;
+        params.timeBudgetUs = _ikTimeBudgetUs;
+        _ik->SetParams(params);
+        _ikResult = _ikCache.Solve(*_ik, 0, _hierarchy, _ikTargetPosition);
     }
 }
 
@@ -313,10 +295,10 @@ void VisualizationApp::Render(MFA::RT::CommandRecordState &recordState)
 
     CalculateJointsLocation();
 
-    for (auto const & arm : _hierarchy)
+    for (int jointIdx = 0; jointIdx < _kinematicChain.JointCount(); jointIdx++)
     {
         glm::vec3 startPoint = endPoint;
-        endPoint = arm.matrix * glm::vec4 {0.0f, 0.0f, 0.0f, 1.0f};
+        endPoint = _kinematicChain.WorldMatrix(jointIdx) * glm::vec4 {0.0f, 0.0f, 0.0f, 1.0f};
 
         auto const middlePoint = (startPoint + endPoint) * 0.5f;
         auto const vector = endPoint - startPoint;
@@ -596,7 +578,56 @@ void VisualizationApp::DisplayParametersWindow()
     ImGui::SeparatorText("IK-Target");
     ImGui::SliderFloat3("IK Target", reinterpret_cast<float *>(&_ikTargetPosition), -10.0f, 10.0f);
     ImGui::Checkbox("Enable IK", &_ikEnabled);
+    {
+        static constexpr char const * methods[] {"Damped least squares", "FABRIK", "CCD"};
+        int method = static_cast<int>(_ikMethod);
+        if (ImGui::Combo("Solver", &method, methods, IM_ARRAYSIZE(methods)))
+        {
+            _ikMethod = static_cast<Shared::InverseKinematic::Method>(method);
+        }
+    }
+    {
+        static constexpr char const * dampingModes[] {"Fixed", "Adaptive (LM)", "Selective (SDLS)"};
+        int dampingMode = static_cast<int>(_dampingMode);
+        if (ImGui::Combo("Damping mode", &dampingMode, dampingModes, IM_ARRAYSIZE(dampingModes)))
+        {
+            _dampingMode = static_cast<Shared::InverseKinematic::DampingMode>(dampingMode);
+        }
+    }
     ImGui::SliderFloat("Damping", &_damping, 0.001f, 1.0f);
+    {
+        static constexpr char const * jacobianModes[] {"Finite difference", "Analytic", "Dual (automatic)"};
+        int jacobianMode = static_cast<int>(_jacobianMode);
+        if (ImGui::Combo("Jacobian", &jacobianMode, jacobianModes, IM_ARRAYSIZE(jacobianModes)))
+        {
+            _jacobianMode = static_cast<Shared::InverseKinematic::JacobianMode>(jacobianMode);
+        }
+    }
+    {
+        static constexpr char const * linearSolvers[] {"Joint space (3n x 3n)", "Task space (3 x 3)"};
+        int linearSolver = static_cast<int>(_linearSolver);
+        if (ImGui::Combo("Linear solver", &linearSolver, linearSolvers, IM_ARRAYSIZE(linearSolvers)))
+        {
+            _linearSolver = static_cast<Shared::InverseKinematic::LinearSolver>(linearSolver);
+        }
+    }
+    ImGui::Checkbox("Two bone fast path", &_useTwoBoneSolver);
+    ImGui::Checkbox("Two bone pole", &_useTwoBonePole);
+    if (_useTwoBonePole == true)
+    {
+        ImGui::SliderFloat3("Pole", reinterpret_cast<float *>(&_twoBonePole), -10.0f, 10.0f);
+    }
+    ImGui::SliderInt("Max iterations", &_ikMaxIterations, 1, 1000);
+    ImGui::SliderFloat("Tolerance", &_ikTolerance, 0.0f, 1.0f);
+    ImGui::SliderFloat("Time budget (us)", &_ikTimeBudgetUs, 0.0f, 10000.0f);
+    ImGui::Text(
+        "Iterations: %d, Error: %f, Time: %.1f us%s",
+        _ikResult.iterations,
+        _ikResult.error,
+        _ikResult.elapsedUs,
+        _ikResult.converged ? " (converged)" : ""
+    );
+    ImGui::Text("Cache hit rate: %.1f%%", _ikCache.GetStatistics().HitRate() * 100.0f);
 
     ImGui::SeparatorText("Joints");
 
@@ -607,8 +638,13 @@ void VisualizationApp::DisplayParametersWindow()
         if (ImGui::TreeNode(name))
         {
             auto &joint = _hierarchy[i];
-            ImGui::SliderFloat("Length", &joint.length, 0.0, 10.0f);
-            ImGui::SliderFloat2("Angle", reinterpret_cast<float *>(&joint.angle), -180.0f, 180.0f);
+            bool isEdited = ImGui::SliderFloat("Length", &joint.length, 0.0, 10.0f);
+            isEdited |= ImGui::SliderFloat2("Angle", reinterpret_cast<float *>(&joint.angle), -180.0f, 180.0f);
+            if (isEdited == true)
+            {
+                // Otherwise the next solve starts from the cached pose and the edit is lost
+                _ikCache.Invalidate(0);
+            }
             ImGui::Checkbox("Is length fixed", &joint.isLengthFixed);
             ImGui::Checkbox("Is angle X fixed", &joint.isX_AngleFixed);
             ImGui::Checkbox("Is angle y fixed", &joint.isY_AngleFixed);
@@ -637,90 +673,9 @@ void VisualizationApp::DisplayParametersWindow()
 
 glm::vec3 VisualizationApp::CalculateJointsLocation()
 {
-    glm::mat4 matrix = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), Math::RightVec3);
-
-    for (auto & arm : _hierarchy)
-    {
-        auto const rotateX = glm::rotate(glm::mat4(1), glm::radians(arm.angle.x), Math::RightVec3);
-        auto const rotateY = glm::rotate(glm::mat4(1), glm::radians(arm.angle.y), Math::UpVec3);
-        auto const translate = glm::translate(glm::mat4(1), Math::UpVec3 * arm.length);
-        matrix *= rotateY * rotateX * translate;
-
-        arm.matrix = matrix;
-    }
-
-    return matrix * glm::vec4{0.0, 0.0, 0.0, 1.0};
-}
-
-//======================================================================================================================
-
-Eigen::MatrixX<float> VisualizationApp::Jacobian(glm::vec3 const & currentEndPoint)
-{
-    // The epsilon here determines the convergence rate and thus the speed
-    static constexpr float lengthEpsilon = 0.025f;
-    static constexpr float angleEpsilon = 0.5f;
-
-    // 3 degrees of freedom per joint (Length + x, y angles)
-    Eigen::MatrixX<float> Jacobian(3, _hierarchy.size() * 3);
-    for (int armIdx = 0; armIdx < _hierarchy.size(); armIdx++)
-    {
-        auto & joint = _hierarchy[armIdx];
-
-        {// Length
-            glm::vec3 prevEndPoint = currentEndPoint;
-            glm::vec3 nextEndPoint = currentEndPoint;
-            if (joint.isLengthFixed == false)
-            {
-                float const jointLength = joint.length;
-                joint.length = jointLength - lengthEpsilon;
-                prevEndPoint = CalculateJointsLocation();
-                joint.length = jointLength + lengthEpsilon;
-                nextEndPoint = CalculateJointsLocation();
-                joint.length = jointLength;
-            }
-            auto const difference = (nextEndPoint - prevEndPoint) / 2.0f * lengthEpsilon;
-            Jacobian(0, 3 * armIdx + 0) = difference.x;
-            Jacobian(1, 3 * armIdx + 0) = difference.y;
-            Jacobian(2, 3 * armIdx + 0) = difference.z;
-        }
-
-        {// X angle
-            glm::vec3 prevEndPoint = currentEndPoint;
-            glm::vec3 nextEndPoint = currentEndPoint;
-            if (joint.isX_AngleFixed == false)
-            {
-                float const angleX = joint.angle.x;
-                joint.angle.x = angleX - angleEpsilon;
-                prevEndPoint = CalculateJointsLocation();
-                joint.angle.x = angleX + angleEpsilon;
-                nextEndPoint = CalculateJointsLocation();
-                joint.angle.x = angleX;
-            }
-            auto const difference = (nextEndPoint - prevEndPoint) / 2.0f * angleEpsilon;
-            Jacobian(0, 3 * armIdx + 1) = difference.x;
-            Jacobian(1, 3 * armIdx + 1) = difference.y;
-            Jacobian(2, 3 * armIdx + 1) = difference.z;
-        }
-
-        {// Y angle
-            glm::vec3 prevEndPoint = currentEndPoint;
-            glm::vec3 nextEndPoint = currentEndPoint;
-            if (joint.isY_AngleFixed == false)
-            {
-                float const angleY = joint.angle.y;
-                joint.angle.y = angleY - angleEpsilon;
-                prevEndPoint = CalculateJointsLocation();
-                joint.angle.y = angleY + angleEpsilon;
-                nextEndPoint = CalculateJointsLocation();
-                joint.angle.y = angleY;
-            }
-            auto const difference = (nextEndPoint - prevEndPoint) / 2.0f * angleEpsilon;
-            Jacobian(0, 3 * armIdx + 2) = difference.x;
-            Jacobian(1, 3 * armIdx + 2) = difference.y;
-            Jacobian(2, 3 * armIdx + 2) = difference.z;
-        }
-    }
-    return Jacobian;
+    _kinematicChain.Assign(_hierarchy);
+    _kinematicChain.Update();
+    return _kinematicChain.EndPoint();
 }
 
 //======================================================================================================================
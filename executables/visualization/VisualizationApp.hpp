@@ -10,9 +10,10 @@
 #include "Time.hpp"
 #include "UI.hpp"
 #include "camera/ArcballCamera.hpp"
+#include "InverseKinematic.hpp"
+#include "SolutionCache.hpp"
 
 #include <SDL_events.h>
-#include <Eigen>
 // TODO: I could have just exported some mesh from GLTF and use the mesh renderer class instead. Why do I do this to myself everytime?
 class VisualizationApp
 {
@@ -48,9 +49,6 @@ private:
 
     glm::vec3 CalculateJointsLocation();
 
-    [[nodiscard]]
-    Eigen::MatrixX<float> Jacobian(glm::vec3 const & endPoint);
-
     // Render parameters
     std::shared_ptr<MFA::Path> _path{};
     MFA::LogicalDevice * _device{};
@@ -102,20 +100,25 @@ private:
     int _shininess = 32;
     float _ambientStrength = 0.25f;
 
-    struct Joint
-    {
-        float length = 3.0f;
-        glm::vec2 angle {};
-
-        bool isLengthFixed = true;
-        bool isX_AngleFixed = false;
-        bool isY_AngleFixed = false;
-
-        glm::mat4 matrix {};
-    };
-    std::vector<Joint> _hierarchy{};
+    Shared::Chain _hierarchy{};
+    // Only the joints that changed since the last frame are re-multiplied
+    Shared::KinematicChain _kinematicChain{};
+    std::unique_ptr<Shared::InverseKinematic> _ik{};
+    Shared::SolutionCache _ikCache{};
 
     glm::vec3 _ikTargetPosition = glm::vec3(7.0f, 1.0f, 7.0f);
     bool _ikEnabled = false;
+    Shared::InverseKinematic::Method _ikMethod = Shared::InverseKinematic::Method::DampedLeastSquares;
     float _damping = 0.25f;
+    Shared::InverseKinematic::DampingMode _dampingMode = Shared::InverseKinematic::DampingMode::Adaptive;
+    Shared::InverseKinematic::JacobianMode _jacobianMode = Shared::InverseKinematic::JacobianMode::Analytic;
+    Shared::InverseKinematic::LinearSolver _linearSolver = Shared::InverseKinematic::LinearSolver::TaskSpace;
+    bool _useTwoBoneSolver = true;
+    bool _useTwoBonePole = false;
+    glm::vec3 _twoBonePole = glm::vec3(0.0f, 0.0f, 10.0f);
+    // Iterations per frame are capped by both count and time so quality does not depend on the frame rate
+    int _ikMaxIterations = 50;
+    float _ikTolerance = 0.01f;
+    float _ikTimeBudgetUs = 1000.0f;
+    Shared::InverseKinematic::Result _ikResult{};
 };
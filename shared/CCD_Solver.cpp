@@ -0,0 +1,128 @@
+#include "CCD_Solver.hpp"
+
+#include "ForwardKinematic.hpp"
+
+#include "BedrockMath.hpp"
+
+namespace Shared::CCD_Solver
+{
+
+    using namespace MFA;
+
+    //-------------------------------------------------------------------------------------------------
+
+    namespace
+    {
+
+        // Angle in radian around the unit axis that brings the projection of "from" onto the projection of "to"
+        float AxisAngle(glm::vec3 const & axis, glm::vec3 const & from, glm::vec3 const & to)
+        {
+            auto const fromProjected = from - axis * glm::dot(axis, from);
+            auto const toProjected = to - axis * glm::dot(axis, to);
+            return std::atan2(glm::dot(axis, glm::cross(fromProjected, toProjected)), glm::dot(fromProjected, toProjected));
+        }
+
+        // Rodrigues rotation of the vector around the unit axis
+        glm::vec3 RotateAroundAxis(glm::vec3 const & vector, glm::vec3 const & axis, float const radian)
+        {
+            float const sin = std::sin(radian);
+            float const cos = std::cos(radian);
+            return vector * cos + glm::cross(axis, vector) * sin + axis * (glm::dot(axis, vector) * (1.0f - cos));
+        }
+
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Result Solve(
+        Chain & chain,
+        glm::vec3 const & target,
+        InverseKinematic::Params const & params,
+        InverseKinematic::Workspace & workspace
+    )
+    {
+        InverseKinematic::Termination const termination(params);
+
+        auto const jointCount = static_cast<int>(chain.size());
+
+        // Pivot and parent rotation of each joint. A joint only moves its descendants, so sweeping from the end
+        // point to the root keeps these valid for the whole sweep.
+        auto & pivots = workspace.positions;
+        auto & parentRotations = workspace.rotations;
+        pivots.resize(jointCount + 1);
+        parentRotations.resize(jointCount);
+
+        auto const updatePivots = [&]()->glm::vec3
+        {
+            glm::mat3 rotation = ForwardKinematic::RootMatrix();
+            glm::vec3 position {};
+            for (int jointIdx = 0; jointIdx < jointCount; ++jointIdx)
+            {
+                auto const & joint = chain[jointIdx];
+                pivots[jointIdx] = position;
+                parentRotations[jointIdx] = rotation;
+                rotation = rotation * ForwardKinematic::JointRotation(joint);
+                position += rotation[1] * joint.length;
+            }
+            pivots[jointCount] = position;
+            return position;
+        };
+
+        InverseKinematic::Result result{};
+        result.endPoint = updatePivots();
+        result.error = glm::length(target - result.endPoint);
+
+        int iteration = 0;
+        for (; iteration < params.maxIterations; ++iteration)
+        {
+            if (termination.ShouldStop(result.error) == true)
+            {
+                break;
+            }
+
+            glm::vec3 endPoint = result.endPoint;
+            for (int jointIdx = jointCount - 1; jointIdx >= 0; --jointIdx)
+            {
+                auto & joint = chain[jointIdx];
+                auto const & pivot = pivots[jointIdx];
+                auto const & parent = parentRotations[jointIdx];
+
+                if (joint.isY_AngleFixed == false)
+                {
+                    auto const & axisY = parent[1];
+                    float const angle = std::clamp(
+                        joint.angle.y + glm::degrees(AxisAngle(axisY, endPoint - pivot, target - pivot)),
+                        joint.minLimit.z,
+                        joint.maxLimit.z
+                    );
+                    endPoint = pivot + RotateAroundAxis(endPoint - pivot, axisY, glm::radians(angle - joint.angle.y));
+                    joint.angle.y = angle;
+                }
+
+                if (joint.isX_AngleFixed == false)
+                {
+                    float const yRadian = glm::radians(joint.angle.y);
+                    auto const axisX = parent[0] * std::cos(yRadian) - parent[2] * std::sin(yRadian);
+                    float const angle = std::clamp(
+                        joint.angle.x + glm::degrees(AxisAngle(axisX, endPoint - pivot, target - pivot)),
+                        joint.minLimit.y,
+                        joint.maxLimit.y
+                    );
+                    endPoint = pivot + RotateAroundAxis(endPoint - pivot, axisX, glm::radians(angle - joint.angle.x));
+                    joint.angle.x = angle;
+                }
+            }
+
+            // Rebuilding the pivots also removes the drift of the incremental end point
+            result.endPoint = updatePivots();
+            result.error = glm::length(target - result.endPoint);
+        }
+
+        result.iterations = iteration;
+        termination.Finish(result);
+        return result;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "InverseKinematic.hpp"
+
+namespace Shared::CCD_Solver
+{
+
+    // Cyclic coordinate descent. Every sweep visits the joints from the end point to the root and rotates each free
+    // angle axis so that the end point swings toward the target, using a closed form angle and no matrix algebra.
+    // Each update is clamped into the angle limits. A sweep is O(n) and counts as one iteration. Bone lengths are
+    // not changed.
+    InverseKinematic::Result Solve(
+        Chain & chain,
+        glm::vec3 const & target,
+        InverseKinematic::Params const & params,
+        InverseKinematic::Workspace & workspace
+    );
+
+}
@@ -0,0 +1,139 @@
+#include "ChainSoA.hpp"
+
+#include "BedrockAssert.hpp"
+
+namespace Shared
+{
+
+    //-------------------------------------------------------------------------------------------------
+
+    ChainSoA::ChainSoA() = default;
+
+    //-------------------------------------------------------------------------------------------------
+
+    ChainSoA::ChainSoA(int const jointCount, int const chainCount)
+    {
+        Resize(jointCount, chainCount);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ChainSoA::Resize(int const jointCount, int const chainCount)
+    {
+        MFA_ASSERT(jointCount >= 0 && chainCount >= 0);
+        _jointCount = jointCount;
+        _chainCount = chainCount;
+        _stride = ((chainCount + LanePadding - 1) / LanePadding) * LanePadding;
+
+        auto const size = static_cast<size_t>(_jointCount) * _stride;
+        _lengths.assign(size, 0.0f);
+        _anglesX.assign(size, 0.0f);
+        _anglesY.assign(size, 0.0f);
+        _flags.assign(size, 0);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ChainSoA::SetChain(int const chainIdx, Chain const & chain)
+    {
+        MFA_ASSERT(static_cast<int>(chain.size()) == _jointCount);
+        for (int jointIdx = 0; jointIdx < _jointCount; jointIdx++)
+        {
+            SetJoint(chainIdx, jointIdx, chain[jointIdx]);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ChainSoA::GetChain(int const chainIdx, Chain & outChain) const
+    {
+        outChain.resize(_jointCount);
+        for (int jointIdx = 0; jointIdx < _jointCount; jointIdx++)
+        {
+            outChain[jointIdx] = GetJoint(chainIdx, jointIdx);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ChainSoA::SetJoint(int const chainIdx, int const jointIdx, Joint const & joint)
+    {
+        MFA_ASSERT(chainIdx >= 0 && chainIdx < _chainCount);
+        MFA_ASSERT(jointIdx >= 0 && jointIdx < _jointCount);
+        auto const idx = jointIdx * _stride + chainIdx;
+        _lengths[idx] = joint.length;
+        _anglesX[idx] = joint.angle.x;
+        _anglesY[idx] = joint.angle.y;
+        _flags[idx] = (joint.isLengthFixed ? LengthFixed : 0) |
+            (joint.isX_AngleFixed ? X_AngleFixed : 0) |
+            (joint.isY_AngleFixed ? Y_AngleFixed : 0);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    Joint ChainSoA::GetJoint(int const chainIdx, int const jointIdx) const
+    {
+        MFA_ASSERT(chainIdx >= 0 && chainIdx < _chainCount);
+        MFA_ASSERT(jointIdx >= 0 && jointIdx < _jointCount);
+        auto const idx = jointIdx * _stride + chainIdx;
+        return Joint {
+            .length = _lengths[idx],
+            .angle = {_anglesX[idx], _anglesY[idx]},
+            .isLengthFixed = (_flags[idx] & LengthFixed) != 0,
+            .isX_AngleFixed = (_flags[idx] & X_AngleFixed) != 0,
+            .isY_AngleFixed = (_flags[idx] & Y_AngleFixed) != 0,
+        };
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int ChainSoA::JointCount() const
+    {
+        return _jointCount;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int ChainSoA::ChainCount() const
+    {
+        return _chainCount;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int ChainSoA::Stride() const
+    {
+        return _stride;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    float const * ChainSoA::Lengths() const
+    {
+        return _lengths.data();
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    float const * ChainSoA::AnglesX() const
+    {
+        return _anglesX.data();
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    float const * ChainSoA::AnglesY() const
+    {
+        return _anglesY.data();
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    uint8_t const * ChainSoA::Flags() const
+    {
+        return _flags.data();
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Joint.hpp"
+
+#include <cstdint>
+
+namespace Shared
+{
+
+    // Structure of arrays storage for many chains that share the same joint count.
+    // Values of a joint are contiguous across chains ([joint * Stride() + chain]) so the forward kinematic kernel
+    // can process several chains (or several perturbations of one chain) per simd register.
+    class ChainSoA
+    {
+    public:
+
+        // Stride is padded to this number of lanes so simd kernels never need a tail loop
+        static constexpr int LanePadding = 8;
+
+        enum DOF_Flag : uint8_t
+        {
+            LengthFixed = 1 << 0,
+            X_AngleFixed = 1 << 1,
+            Y_AngleFixed = 1 << 2,
+        };
+
+        explicit ChainSoA();
+
+        explicit ChainSoA(int jointCount, int chainCount);
+
+        void Resize(int jointCount, int chainCount);
+
+        void SetChain(int chainIdx, Chain const & chain);
+
+        void GetChain(int chainIdx, Chain & outChain) const;
+
+        void SetJoint(int chainIdx, int jointIdx, Joint const & joint);
+
+        [[nodiscard]]
+        Joint GetJoint(int chainIdx, int jointIdx) const;
+
+        [[nodiscard]]
+        int JointCount() const;
+
+        [[nodiscard]]
+        int ChainCount() const;
+
+        [[nodiscard]]
+        int Stride() const;
+
+        [[nodiscard]]
+        float const * Lengths() const;
+
+        [[nodiscard]]
+        float const * AnglesX() const;
+
+        [[nodiscard]]
+        float const * AnglesY() const;
+
+        [[nodiscard]]
+        uint8_t const * Flags() const;
+
+    private:
+
+        int _jointCount {};
+        int _chainCount {};
+        int _stride {};
+
+        std::vector<float> _lengths{};
+        std::vector<float> _anglesX{};          // In degree
+        std::vector<float> _anglesY{};          // In degree
+        std::vector<uint8_t> _flags{};
+
+    };
+
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cmath>
+
+namespace Shared
+{
+
+    // Forward mode automatic differentiation number. It carries the value and its derivative with respect to Width
+    // independent inputs, so one pass through a function gives Width derivative columns at once. The derivative lanes
+    // are plain arrays that the compiler vectorizes.
+    template<int Width>
+    struct Dual
+    {
+        static constexpr int LaneCount = Width;
+
+        float value {};
+        float derivative[Width] {};
+
+        Dual() = default;
+
+        // Constant, every derivative is zero
+        Dual(float const constant)
+            : value(constant)
+        {
+        }
+
+        // Input number lane of the function, its derivative is one in that lane
+        [[nodiscard]]
+        static Dual Variable(float const value, int const lane)
+        {
+            Dual result {value};
+            result.derivative[lane] = 1.0f;
+            return result;
+        }
+
+        Dual & operator+=(Dual const & other)
+        {
+            value += other.value;
+            for (int i = 0; i < Width; i++)
+            {
+                derivative[i] += other.derivative[i];
+            }
+            return *this;
+        }
+
+        Dual & operator-=(Dual const & other)
+        {
+            value -= other.value;
+            for (int i = 0; i < Width; i++)
+            {
+                derivative[i] -= other.derivative[i];
+            }
+            return *this;
+        }
+
+        Dual & operator*=(Dual const & other)
+        {
+            for (int i = 0; i < Width; i++)
+            {
+                derivative[i] = derivative[i] * other.value + value * other.derivative[i];
+            }
+            value *= other.value;
+            return *this;
+        }
+
+        Dual & operator*=(float const scale)
+        {
+            value *= scale;
+            for (int i = 0; i < Width; i++)
+            {
+                derivative[i] *= scale;
+            }
+            return *this;
+        }
+    };
+
+    template<int Width>
+    [[nodiscard]]
+    Dual<Width> operator+(Dual<Width> lhs, Dual<Width> const & rhs)
+    {
+        return lhs += rhs;
+    }
+
+    template<int Width>
+    [[nodiscard]]
+    Dual<Width> operator-(Dual<Width> lhs, Dual<Width> const & rhs)
+    {
+        return lhs -= rhs;
+    }
+
+    template<int Width>
+    [[nodiscard]]
+    Dual<Width> operator-(Dual<Width> value)
+    {
+        return value *= -1.0f;
+    }
+
+    template<int Width>
+    [[nodiscard]]
+    Dual<Width> operator*(Dual<Width> lhs, Dual<Width> const & rhs)
+    {
+        return lhs *= rhs;
+    }
+
+    template<int Width>
+    [[nodiscard]]
+    Dual<Width> operator*(Dual<Width> lhs, float const rhs)
+    {
+        return lhs *= rhs;
+    }
+
+    template<int Width>
+    [[nodiscard]]
+    Dual<Width> operator*(float const lhs, Dual<Width> rhs)
+    {
+        return rhs *= lhs;
+    }
+
+    // sin(a + b * e) = sin(a) + cos(a) * b * e
+    template<int Width>
+    [[nodiscard]]
+    Dual<Width> sin(Dual<Width> const & x)
+    {
+        Dual<Width> result {};
+        result.value = std::sin(x.value);
+        float const slope = std::cos(x.value);
+        for (int i = 0; i < Width; i++)
+        {
+            result.derivative[i] = x.derivative[i] * slope;
+        }
+        return result;
+    }
+
+    template<int Width>
+    [[nodiscard]]
+    Dual<Width> cos(Dual<Width> const & x)
+    {
+        Dual<Width> result {};
+        result.value = std::cos(x.value);
+        float const slope = -std::sin(x.value);
+        for (int i = 0; i < Width; i++)
+        {
+            result.derivative[i] = x.derivative[i] * slope;
+        }
+        return result;
+    }
+
+}
@@ -0,0 +1,187 @@
+#include "FABRIK_Solver.hpp"
+
+#include "ForwardKinematic.hpp"
+
+#include "BedrockAssert.hpp"
+#include "BedrockMath.hpp"
+
+namespace Shared::FABRIK_Solver
+{
+
+    using namespace MFA;
+
+    //-------------------------------------------------------------------------------------------------
+
+    void CalculatePositions(Chain const & chain, std::vector<glm::vec3> & outPositions)
+    {
+        outPositions.resize(chain.size() + 1);
+        outPositions[0] = glm::vec3{};
+
+        glm::mat3 rotation = ForwardKinematic::RootMatrix();
+        for (size_t jointIdx = 0; jointIdx < chain.size(); ++jointIdx)
+        {
+            auto const & joint = chain[jointIdx];
+            rotation = rotation * ForwardKinematic::JointRotation(joint);
+            outPositions[jointIdx + 1] = outPositions[jointIdx] + rotation[1] * joint.length;
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ApplyPositions(Chain & chain, std::vector<glm::vec3> & positions)
+    {
+        MFA_ASSERT(positions.size() == chain.size() + 1);
+
+        glm::mat3 rotation = ForwardKinematic::RootMatrix();
+        for (size_t jointIdx = 0; jointIdx < chain.size(); ++jointIdx)
+        {
+            auto & joint = chain[jointIdx];
+
+            auto const bone = positions[jointIdx + 1] - positions[jointIdx];
+            if (Math::IsNearZero(bone) == false && (joint.isX_AngleFixed == false || joint.isY_AngleFixed == false))
+            {
+                float const sign = joint.length < 0.0f ? -1.0f : 1.0f;
+                auto const angle = ForwardKinematic::AnglesFromDirection(
+                    glm::transpose(rotation) * bone * sign,
+                    joint.angle
+                );
+                if (joint.isX_AngleFixed == false)
+                {
+                    joint.angle.x = std::clamp(angle.x, joint.minLimit.y, joint.maxLimit.y);
+                }
+                if (joint.isY_AngleFixed == false)
+                {
+                    joint.angle.y = std::clamp(angle.y, joint.minLimit.z, joint.maxLimit.z);
+                }
+            }
+
+            rotation = rotation * ForwardKinematic::JointRotation(joint);
+            positions[jointIdx + 1] = positions[jointIdx] + rotation[1] * joint.length;
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Result Solve(
+        Chain & chain,
+        glm::vec3 const & target,
+        InverseKinematic::Params const & params,
+        InverseKinematic::Workspace & workspace
+    )
+    {
+        InverseKinematic::Termination const termination(params);
+
+        auto & positions = workspace.positions;
+        auto & boneLengths = workspace.boneLengths;
+
+        CalculatePositions(chain, positions);
+
+        auto const jointCount = static_cast<int>(chain.size());
+
+        InverseKinematic::Result result{};
+        result.endPoint = positions.back();
+        result.error = glm::length(target - result.endPoint);
+
+        if (jointCount == 0)
+        {
+            termination.Finish(result);
+            return result;
+        }
+
+        // Constrained joints need the positions to be projected back after every iteration
+        bool hasConstraint = false;
+        boneLengths.resize(jointCount);
+        for (int jointIdx = 0; jointIdx < jointCount; ++jointIdx)
+        {
+            auto const & joint = chain[jointIdx];
+            boneLengths[jointIdx] = std::abs(joint.length);
+            hasConstraint |= joint.isX_AngleFixed == true || joint.isY_AngleFixed == true || HasLimits(joint) == true;
+        }
+
+        // Moves "to" along the line toward "from" until it is at the bone length distance. A joint that landed on
+        // "from" keeps the direction the bone had before the pass.
+        auto const reach = [](
+            glm::vec3 const & from,
+            glm::vec3 const & to,
+            glm::vec3 const & previousDirection,
+            float const length
+        )
+        {
+            auto direction = to - from;
+            float distance = glm::length(direction);
+            if (distance <= glm::epsilon<float>())
+            {
+                direction = previousDirection;
+                distance = glm::length(direction);
+                if (distance <= glm::epsilon<float>())
+                {
+                    return from;
+                }
+            }
+            return from + direction * (length / distance);
+        };
+
+        glm::vec3 const root = positions[0];
+
+        int iteration = 0;
+        for (; iteration < params.maxIterations; ++iteration)
+        {
+            if (termination.ShouldStop(result.error) == true)
+            {
+                break;
+            }
+
+            // Backward: pin the end point to the target and walk toward the root
+            glm::vec3 previousChild = positions[jointCount];
+            positions[jointCount] = target;
+            for (int jointIdx = jointCount - 1; jointIdx >= 0; --jointIdx)
+            {
+                auto const current = positions[jointIdx];
+                positions[jointIdx] = reach(
+                    positions[jointIdx + 1],
+                    current,
+                    current - previousChild,
+                    boneLengths[jointIdx]
+                );
+                previousChild = current;
+            }
+
+            // Forward: pin the root back and walk toward the end point
+            glm::vec3 previousParent = positions[0];
+            positions[0] = root;
+            for (int jointIdx = 0; jointIdx < jointCount; ++jointIdx)
+            {
+                auto const current = positions[jointIdx + 1];
+                positions[jointIdx + 1] = reach(
+                    positions[jointIdx],
+                    current,
+                    current - previousParent,
+                    boneLengths[jointIdx]
+                );
+                previousParent = current;
+            }
+
+            if (hasConstraint == true)
+            {
+                ApplyPositions(chain, positions);
+            }
+
+            result.endPoint = positions[jointCount];
+            result.error = glm::length(target - result.endPoint);
+        }
+
+        if (hasConstraint == false && iteration > 0)
+        {
+            ApplyPositions(chain, positions);
+            result.endPoint = positions[jointCount];
+            result.error = glm::length(target - result.endPoint);
+        }
+
+        result.iterations = iteration;
+        termination.Finish(result);
+        return result;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
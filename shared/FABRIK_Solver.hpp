@@ -0,0 +1,25 @@
+#pragma once
+
+#include "InverseKinematic.hpp"
+
+namespace Shared::FABRIK_Solver
+{
+
+    // Forward and backward reaching inverse kinematic. Iterates on the contiguous joint positions of
+    // workspace.positions and converts them back to joint angles once at the end. Bone lengths are kept.
+    // Joints with a fixed or limited angle are projected back onto their constraint after every iteration.
+    InverseKinematic::Result Solve(
+        Chain & chain,
+        glm::vec3 const & target,
+        InverseKinematic::Params const & params,
+        InverseKinematic::Workspace & workspace
+    );
+
+    // Pivot of every joint followed by the end point (chain.size() + 1 positions)
+    void CalculatePositions(Chain const & chain, std::vector<glm::vec3> & outPositions);
+
+    // Writes the joint angles that reproduce the bone directions of the positions, clamped into the joint limits.
+    // Positions are rewritten with the resulting forward kinematic so they stay consistent with the constraints.
+    void ApplyPositions(Chain & chain, std::vector<glm::vec3> & positions);
+
+}
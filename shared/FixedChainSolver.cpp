@@ -0,0 +1,61 @@
+#include "FixedChainSolver.hpp"
+
+#include <utility>
+
+namespace Shared
+{
+
+    //-------------------------------------------------------------------------------------------------
+
+    namespace
+    {
+        static constexpr int MaskCount = AllDOF_Bits + 1;
+
+        template<int JointCount, size_t ... Masks>
+        constexpr std::array<FixedChainSolveFunction, MaskCount> MakeMaskTable(std::index_sequence<Masks...>)
+        {
+            return {&FixedChainSolver<JointCount, static_cast<uint8_t>(Masks)>::Solve...};
+        }
+
+        template<size_t ... JointCounts>
+        constexpr std::array<std::array<FixedChainSolveFunction, MaskCount>, sizeof...(JointCounts)> MakeTable(
+            std::index_sequence<JointCounts...>
+        )
+        {
+            return {MakeMaskTable<static_cast<int>(JointCounts) + 1>(std::make_index_sequence<MaskCount>{})...};
+        }
+
+        // [jointCount - 1][DOF mask]
+        static constexpr auto SolverTable = MakeTable(std::make_index_sequence<MaxFixedChainJointCount>{});
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    FixedChainSolveFunction FindFixedChainSolver(Chain const & chain)
+    {
+        auto const jointCount = static_cast<int>(chain.size());
+        if (jointCount == 0 || jointCount > MaxFixedChainJointCount)
+        {
+            return nullptr;
+        }
+
+        auto const mask = ActiveDOF_Mask(chain[0]);
+        for (auto const & joint : chain)
+        {
+            if (ActiveDOF_Mask(joint) != mask)
+            {
+                return nullptr;
+            }
+        }
+        // Nothing to solve for
+        if (mask == 0)
+        {
+            return nullptr;
+        }
+
+        return SolverTable[jointCount - 1][mask];
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
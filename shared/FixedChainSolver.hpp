@@ -0,0 +1,201 @@
+#pragma once
+
+#include "InverseKinematic.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <array>
+#include <bit>
+
+namespace Shared
+{
+
+    // Damped least squares solver for a chain whose joint count and active degrees of freedom are known at compile
+    // time. All matrices have a fixed size so the compiler can unroll the joint loops and keep everything on the stack.
+    // Every joint of the chain must have the same active DOF mask.
+    template<int JointCount, uint8_t DOF_Mask>
+    struct FixedChainSolver
+    {
+        static constexpr int ActiveDOF_PerJoint = std::popcount(static_cast<unsigned>(DOF_Mask));
+        static constexpr int ColumnCount = JointCount * ActiveDOF_PerJoint;
+
+        using JacobianMatrix = Eigen::Matrix<float, 3, ColumnCount>;
+        using StepVector = Eigen::Matrix<float, ColumnCount, 1>;
+
+        // Analytic jacobian of the end point, only active DOFs get a column
+        static glm::vec3 Jacobian(Joint const * joints, JacobianMatrix & outJacobian)
+        {
+            static constexpr float degreeToRadian = glm::pi<float>() / 180.0f;
+
+            std::array<glm::vec3, JointCount> pivots{};
+            std::array<glm::vec3, JointCount> axesX{};
+            std::array<glm::vec3, JointCount> axesY{};
+            std::array<glm::vec3, JointCount> directions{};
+
+            // Rotation and position are kept separately, the root is a 90 degree rotation around the x axis
+            glm::mat3 rotation {
+                glm::vec3{1.0f, 0.0f, 0.0f},
+                glm::vec3{0.0f, 0.0f, 1.0f},
+                glm::vec3{0.0f, -1.0f, 0.0f}
+            };
+            glm::vec3 position {};
+            for (int i = 0; i < JointCount; i++)
+            {
+                float const xRadian = glm::radians(joints[i].angle.x);
+                float const yRadian = glm::radians(joints[i].angle.y);
+                float const sa = std::sin(xRadian), ca = std::cos(xRadian);
+                float const sb = std::sin(yRadian), cb = std::cos(yRadian);
+
+                // Columns of rotateY * rotateX
+                glm::mat3 const local {
+                    glm::vec3{cb, 0.0f, -sb},
+                    glm::vec3{sb * sa, ca, cb * sa},
+                    glm::vec3{sb * ca, -sa, cb * ca}
+                };
+
+                pivots[i] = position;
+                axesY[i] = rotation[1];
+                rotation = rotation * local;
+                axesX[i] = rotation[0];
+                directions[i] = rotation[1];
+                position += directions[i] * joints[i].length;
+            }
+            glm::vec3 const endPoint = position;
+
+            for (int i = 0; i < JointCount; i++)
+            {
+                int column = i * ActiveDOF_PerJoint;
+                auto const toEnd = endPoint - pivots[i];
+                if constexpr ((DOF_Mask & LengthBit) != 0)
+                {
+                    outJacobian.col(column++) << directions[i].x, directions[i].y, directions[i].z;
+                }
+                if constexpr ((DOF_Mask & X_AngleBit) != 0)
+                {
+                    auto const c = glm::cross(axesX[i], toEnd) * degreeToRadian;
+                    outJacobian.col(column++) << c.x, c.y, c.z;
+                }
+                if constexpr ((DOF_Mask & Y_AngleBit) != 0)
+                {
+                    auto const c = glm::cross(axesY[i], toEnd) * degreeToRadian;
+                    outJacobian.col(column++) << c.x, c.y, c.z;
+                }
+            }
+
+            return endPoint;
+        }
+
+        // Only the damping of the workspace is used, it carries over to the next solve when warmStart is set. The
+        // jacobian has a fixed size and is rebuilt on every solve, so workspace.J is left alone.
+        static InverseKinematic::Result Solve(
+            Joint * joints,
+            glm::vec3 const & target,
+            InverseKinematic::Params const & params,
+            InverseKinematic::Workspace & workspace
+        )
+        {
+            InverseKinematic::Termination const termination(params);
+            InverseKinematic::Result result{};
+
+            for (int i = 0; i < JointCount; i++)
+            {
+                ClampToLimits(joints[i]);
+            }
+
+            JacobianMatrix J{};
+            glm::vec3 endPoint = Jacobian(joints, J);
+            result.error = glm::length(target - endPoint);
+
+            bool const isWarmStart = workspace.warmStart == true && workspace.damping > 0.0f;
+            InverseKinematic::AdaptiveDamping damping(params, isWarmStart == true ? workspace.damping : params.damping);
+            workspace.warmStart = false;
+            workspace.isJacobianReusable = false;
+            std::array<Joint, JointCount> previousJoints{};
+
+            for (int iteration = 0; iteration < params.maxIterations; iteration++)
+            {
+                if (termination.ShouldStop(result.error))
+                {
+                    break;
+                }
+                result.iterations = iteration + 1;
+
+                auto const dEGlm = target - endPoint;
+                Eigen::Vector3f const dE {dEGlm.x, dEGlm.y, dEGlm.z};
+
+                // dTheta = JT * (J * JT + damping * I)^-1 * dE
+                Eigen::Matrix3f JxJT = J * J.transpose();
+                JxJT.diagonal().array() += damping.GetDamping();
+                Eigen::Vector3f const y = JxJT.ldlt().solve(dE);
+                StepVector dTheta = J.transpose() * y;
+
+                // The step is projected into the joint limits, dTheta keeps the applied step
+                auto const applyStep = [&dTheta](float & value, int const column, float const min, float const max)
+                {
+                    float const next = std::clamp(value + dTheta(column), min, max);
+                    dTheta(column) = next - value;
+                    value = next;
+                };
+
+                std::copy(joints, joints + JointCount, previousJoints.begin());
+                for (int i = 0; i < JointCount; i++)
+                {
+                    auto & joint = joints[i];
+                    int column = i * ActiveDOF_PerJoint;
+                    if constexpr ((DOF_Mask & LengthBit) != 0)
+                    {
+                        applyStep(joint.length, column++, joint.minLimit.x, joint.maxLimit.x);
+                    }
+                    if constexpr ((DOF_Mask & X_AngleBit) != 0)
+                    {
+                        applyStep(joint.angle.x, column++, joint.minLimit.y, joint.maxLimit.y);
+                    }
+                    if constexpr ((DOF_Mask & Y_AngleBit) != 0)
+                    {
+                        applyStep(joint.angle.y, column++, joint.minLimit.z, joint.maxLimit.z);
+                    }
+                }
+
+                if (params.dampingMode == InverseKinematic::DampingMode::Adaptive)
+                {
+                    JacobianMatrix nextJ{};
+                    auto const nextEndPoint = Jacobian(joints, nextJ);
+                    float const nextError = glm::length(target - nextEndPoint);
+                    Eigen::Vector3f const predicted = dE - J * dTheta;
+                    if (damping.Update(result.error * result.error, nextError * nextError, predicted.squaredNorm()) == false)
+                    {
+                        std::copy(previousJoints.begin(), previousJoints.end(), joints);
+                        continue;
+                    }
+                    J = nextJ;
+                    endPoint = nextEndPoint;
+                    result.error = nextError;
+                    continue;
+                }
+
+                endPoint = Jacobian(joints, J);
+                result.error = glm::length(target - endPoint);
+            }
+
+            workspace.damping = damping.GetDamping();
+            result.endPoint = endPoint;
+            termination.Finish(result);
+            return result;
+        }
+    };
+
+    // Largest joint count that has a compile time specialization
+    static constexpr int MaxFixedChainJointCount = 6;
+
+    using FixedChainSolveFunction = InverseKinematic::Result (*)(
+        Joint * joints,
+        glm::vec3 const & target,
+        InverseKinematic::Params const & params,
+        InverseKinematic::Workspace & workspace
+    );
+
+    // Returns the specialization matching the chain length and DOF mask or nullptr if there is none.
+    [[nodiscard]]
+    FixedChainSolveFunction FindFixedChainSolver(Chain const & chain);
+
+}
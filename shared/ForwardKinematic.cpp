@@ -0,0 +1,110 @@
+#include "ForwardKinematic.hpp"
+
+#include "BedrockMath.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace Shared::ForwardKinematic
+{
+
+    using namespace MFA;
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::mat4 RootMatrix()
+    {
+        return glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), Math::RightVec3);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::mat4 JointMatrix(Joint const & joint)
+    {
+        auto const rotateX = glm::rotate(glm::mat4(1), glm::radians(joint.angle.x), Math::RightVec3);
+        auto const rotateY = glm::rotate(glm::mat4(1), glm::radians(joint.angle.y), Math::UpVec3);
+        auto const translate = glm::translate(glm::mat4(1), Math::UpVec3 * joint.length);
+        return rotateY * rotateX * translate;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::mat3 JointRotation(Joint const & joint)
+    {
+        float const xRadian = glm::radians(joint.angle.x);
+        float const yRadian = glm::radians(joint.angle.y);
+        float const sa = std::sin(xRadian), ca = std::cos(xRadian);
+        float const sb = std::sin(yRadian), cb = std::cos(yRadian);
+        return glm::mat3 {
+            glm::vec3{cb, 0.0f, -sb},
+            glm::vec3{sb * sa, ca, cb * sa},
+            glm::vec3{sb * ca, -sa, cb * ca}
+        };
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::vec2 AnglesFromDirection(glm::vec3 const & localDirection, glm::vec2 const & currentAngle)
+    {
+        // rotateY(b) * rotateX(a) * up = (sin(b) * sin(a), cos(a), cos(b) * sin(a))
+        auto const direction = glm::normalize(localDirection);
+        float const x = glm::degrees(Math::ACosSafe(direction.y));
+
+        // Moves an angle by whole turns so that it is as close as possible to the reference
+        auto const closestTurn = [](float const angle, float const reference)->float
+        {
+            return angle + 360.0f * std::round((reference - angle) / 360.0f);
+        };
+
+        float const sinX = std::sqrt(direction.x * direction.x + direction.z * direction.z);
+        if (sinX <= glm::epsilon<float>())
+        {
+            // Pointing along the up axis, the y angle does not matter
+            return glm::vec2{closestTurn(x, currentAngle.x), currentAngle.y};
+        }
+
+        float const y = glm::degrees(std::atan2(direction.x, direction.z));
+
+        // (x, y) and (-x, y + 180) describe the same direction
+        glm::vec2 const first {closestTurn(x, currentAngle.x), closestTurn(y, currentAngle.y)};
+        glm::vec2 const second {closestTurn(-x, currentAngle.x), closestTurn(y + 180.0f, currentAngle.y)};
+
+        auto const distance = [&currentAngle](glm::vec2 const & angle)->float
+        {
+            return std::abs(angle.x - currentAngle.x) + std::abs(angle.y - currentAngle.y);
+        };
+        return distance(first) <= distance(second) ? first : second;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::vec3 Calculate(Joint const * joints, int const jointCount, glm::mat4 * outMatrices)
+    {
+        glm::mat4 matrix = RootMatrix();
+
+        for (int i = 0; i < jointCount; i++)
+        {
+            matrix *= JointMatrix(joints[i]);
+            if (outMatrices != nullptr)
+            {
+                outMatrices[i] = matrix;
+            }
+        }
+
+        return matrix * glm::vec4{0.0, 0.0, 0.0, 1.0};
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::vec3 Calculate(Chain const & chain, std::vector<glm::mat4> * outMatrices)
+    {
+        if (outMatrices != nullptr)
+        {
+            outMatrices->resize(chain.size());
+            return Calculate(chain.data(), static_cast<int>(chain.size()), outMatrices->data());
+        }
+        return Calculate(chain.data(), static_cast<int>(chain.size()), nullptr);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Joint.hpp"
+
+#include <cmath>
+
+namespace Shared::ForwardKinematic
+{
+
+    // Transform of the chain base. Joints grow along the up vector of their parent.
+    [[nodiscard]]
+    glm::mat4 RootMatrix();
+
+    // Local transform of a single joint: rotateY * rotateX * translate(length)
+    [[nodiscard]]
+    glm::mat4 JointMatrix(Joint const & joint);
+
+    // Rotation part of the joint matrix: rotateY * rotateX
+    [[nodiscard]]
+    glm::mat3 JointRotation(Joint const & joint);
+
+    // Inverse of the joint rotation for the bone direction: returns the x, y angles (degree) that make the joint point
+    // along localDirection (expressed in the parent frame). The solution closest to currentAngle is picked.
+    [[nodiscard]]
+    glm::vec2 AnglesFromDirection(glm::vec3 const & localDirection, glm::vec2 const & currentAngle);
+
+    // Returns the end point of the chain. outMatrices is optional and receives the world matrix of each joint.
+    glm::vec3 Calculate(Joint const * joints, int jointCount, glm::mat4 * outMatrices = nullptr);
+
+    glm::vec3 Calculate(Chain const & chain, std::vector<glm::mat4> * outMatrices = nullptr);
+
+    // Scalar generic form of the same math. With float it matches Calculate, with Dual it carries exact derivatives
+    // of the transform with respect to the seeded joint values (see InverseKinematic::DualJacobian). A new joint type
+    // only has to be written here once to get its jacobian.
+    template<typename Scalar>
+    struct Transform
+    {
+        Scalar rotation[3][3] {};           // [column][row] like glm
+        Scalar position[3] {};
+    };
+
+    template<typename Scalar>
+    struct JointValues
+    {
+        Scalar length {};
+        Scalar angleX {};                   // In degree
+        Scalar angleY {};
+    };
+
+    template<typename Scalar>
+    [[nodiscard]]
+    Transform<Scalar> ToTransform(glm::mat4 const & matrix)
+    {
+        Transform<Scalar> transform {};
+        for (int column = 0; column < 3; column++)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                transform.rotation[column][row] = Scalar(matrix[column][row]);
+            }
+            transform.position[column] = Scalar(matrix[3][column]);
+        }
+        return transform;
+    }
+
+    // transform * rotateY * rotateX * translate(length)
+    template<typename Scalar>
+    void ApplyJoint(Transform<Scalar> & transform, JointValues<Scalar> const & joint)
+    {
+        using std::sin;
+        using std::cos;
+        static constexpr float degreeToRadian = 3.14159265358979f / 180.0f;
+
+        Scalar const xRadian = joint.angleX * degreeToRadian;
+        Scalar const yRadian = joint.angleY * degreeToRadian;
+        Scalar const sa = sin(xRadian), ca = cos(xRadian);
+        Scalar const sb = sin(yRadian), cb = cos(yRadian);
+
+        // Columns of rotateY(b) * rotateX(a), the same as JointRotation
+        Scalar const local[3][3]
+        {
+            {cb, Scalar(0.0f), -sb},
+            {sb * sa, ca, cb * sa},
+            {sb * ca, -sa, cb * ca}
+        };
+
+        auto & r = transform.rotation;
+        Scalar rotation[3][3] {};
+        for (int column = 0; column < 3; column++)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                rotation[column][row] = r[0][row] * local[column][0] + r[1][row] * local[column][1] +
+                    r[2][row] * local[column][2];
+            }
+        }
+
+        for (int column = 0; column < 3; column++)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                r[column][row] = rotation[column][row];
+            }
+        }
+
+        for (int row = 0; row < 3; row++)
+        {
+            transform.position[row] += r[1][row] * joint.length;
+        }
+    }
+
+    // Transform after the joints in [begin, end). getJoint(index) returns the JointValues<Scalar> of a joint, that is
+    // where the caller seeds the variables it differentiates against.
+    template<typename Scalar, typename GetJoint>
+    [[nodiscard]]
+    Transform<Scalar> CalculateTransform(
+        Transform<Scalar> transform,
+        int const begin,
+        int const end,
+        GetJoint const & getJoint
+    )
+    {
+        for (int i = begin; i < end; i++)
+        {
+            ApplyJoint<Scalar>(transform, getJoint(i));
+        }
+        return transform;
+    }
+
+}
@@ -0,0 +1,219 @@
+#include "ForwardKinematicSoA.hpp"
+
+#include "ForwardKinematicSoA_Kernel.hpp"
+
+#include "BedrockAssert.hpp"
+
+#include <cmath>
+
+#if defined(SHARED_AVX2_KERNEL) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define SHARED_NEON_KERNEL
+#include <arm_neon.h>
+#endif
+
+namespace Shared::ForwardKinematicSoA
+{
+
+    namespace Kernel
+    {
+
+        struct ScalarLanes
+        {
+            using Type = float;
+            static constexpr int Width = 1;
+
+            static Type Set(float const value) { return value; }
+            static Type Load(float const * ptr) { return *ptr; }
+            static void Store(float * ptr, Type const value) { *ptr = value; }
+            static Type Add(Type const a, Type const b) { return a + b; }
+            static Type Sub(Type const a, Type const b) { return a - b; }
+            static Type Mul(Type const a, Type const b) { return a * b; }
+            static Type Round(Type const a) { return std::nearbyint(a); }
+        };
+
+        //-------------------------------------------------------------------------------------------------
+
+        void CalculateScalar(Params const & params)
+        {
+            Calculate<ScalarLanes>(params);
+        }
+
+        //-------------------------------------------------------------------------------------------------
+
+#if defined(SHARED_NEON_KERNEL)
+
+        struct NEON_Lanes
+        {
+            using Type = float32x4_t;
+            static constexpr int Width = 4;
+
+            static Type Set(float const value) { return vdupq_n_f32(value); }
+            static Type Load(float const * ptr) { return vld1q_f32(ptr); }
+            static void Store(float * ptr, Type const value) { vst1q_f32(ptr, value); }
+            static Type Add(Type const a, Type const b) { return vaddq_f32(a, b); }
+            static Type Sub(Type const a, Type const b) { return vsubq_f32(a, b); }
+            static Type Mul(Type const a, Type const b) { return vmulq_f32(a, b); }
+            static Type Round(Type const a) { return vrndnq_f32(a); }
+        };
+
+        void CalculateNEON(Params const & params)
+        {
+            Calculate<NEON_Lanes>(params);
+        }
+
+#endif
+
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    static bool CpuSupportsAVX2()
+    {
+#if defined(SHARED_AVX2_KERNEL)
+#if defined(_MSC_VER)
+        int info[4] {};
+        __cpuid(info, 1);
+        bool const osUsesXSave = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+        if (osUsesXSave == false || (_xgetbv(0) & 0x6) != 0x6)
+        {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+#else
+        return false;
+#endif
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    KernelType ActiveKernel()
+    {
+        static KernelType const kernel = []()->KernelType
+        {
+            if (IsSupported(KernelType::AVX2))
+            {
+                return KernelType::AVX2;
+            }
+            if (IsSupported(KernelType::NEON))
+            {
+                return KernelType::NEON;
+            }
+            return KernelType::Scalar;
+        }();
+        return kernel;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool IsSupported(KernelType const kernel)
+    {
+        switch (kernel)
+        {
+            case KernelType::Scalar:
+                return true;
+            case KernelType::AVX2:
+            {
+                static bool const supported = CpuSupportsAVX2();
+                return supported;
+            }
+            case KernelType::NEON:
+#if defined(SHARED_NEON_KERNEL)
+                return true;
+#else
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    char const * KernelName(KernelType const kernel)
+    {
+        switch (kernel)
+        {
+            case KernelType::Scalar:
+                return "Scalar";
+            case KernelType::AVX2:
+                return "AVX2";
+            case KernelType::NEON:
+                return "NEON";
+        }
+        return "Unknown";
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void Calculate(
+        ChainSoA const & chains,
+        PointsSoA & outEndPoints,
+        PointsSoA * outJoints,
+        KernelType kernel
+    )
+    {
+        auto const stride = chains.Stride();
+        outEndPoints.x.resize(stride);
+        outEndPoints.y.resize(stride);
+        outEndPoints.z.resize(stride);
+
+        Kernel::Params params {
+            .lengths = chains.Lengths(),
+            .anglesX = chains.AnglesX(),
+            .anglesY = chains.AnglesY(),
+            .jointCount = chains.JointCount(),
+            .stride = stride,
+            .laneCount = stride,
+            .outEndX = outEndPoints.x.data(),
+            .outEndY = outEndPoints.y.data(),
+            .outEndZ = outEndPoints.z.data(),
+            .outJointX = nullptr,
+            .outJointY = nullptr,
+            .outJointZ = nullptr,
+        };
+
+        if (outJoints != nullptr)
+        {
+            auto const size = static_cast<size_t>(chains.JointCount()) * stride;
+            outJoints->x.resize(size);
+            outJoints->y.resize(size);
+            outJoints->z.resize(size);
+            params.outJointX = outJoints->x.data();
+            params.outJointY = outJoints->y.data();
+            params.outJointZ = outJoints->z.data();
+        }
+
+        if (IsSupported(kernel) == false)
+        {
+            kernel = KernelType::Scalar;
+        }
+
+        switch (kernel)
+        {
+#if defined(SHARED_AVX2_KERNEL)
+            case KernelType::AVX2:
+                Kernel::CalculateAVX2(params);
+                break;
+#endif
+#if defined(SHARED_NEON_KERNEL)
+            case KernelType::NEON:
+                Kernel::CalculateNEON(params);
+                break;
+#endif
+            default:
+                Kernel::CalculateScalar(params);
+                break;
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ChainSoA.hpp"
+
+namespace Shared::ForwardKinematicSoA
+{
+
+    enum class KernelType
+    {
+        Scalar,
+        AVX2,                   // 8 chains per iteration
+        NEON,                   // 4 chains per iteration
+    };
+
+    struct PointsSoA
+    {
+        std::vector<float> x{};
+        std::vector<float> y{};
+        std::vector<float> z{};
+
+        [[nodiscard]]
+        glm::vec3 Get(int const idx) const
+        {
+            return glm::vec3{x[idx], y[idx], z[idx]};
+        }
+    };
+
+    // Best kernel supported by the cpu that we are running on
+    [[nodiscard]]
+    KernelType ActiveKernel();
+
+    [[nodiscard]]
+    bool IsSupported(KernelType kernel);
+
+    [[nodiscard]]
+    char const * KernelName(KernelType kernel);
+
+    // Calculates the end point of every chain. outJoints is optional and receives the end position of every joint
+    // laid out like the chain itself ([joint * Stride() + chain]).
+    void Calculate(
+        ChainSoA const & chains,
+        PointsSoA & outEndPoints,
+        PointsSoA * outJoints = nullptr,
+        KernelType kernel = ActiveKernel()
+    );
+
+}
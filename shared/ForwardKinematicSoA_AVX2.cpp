@@ -0,0 +1,37 @@
+// This file is compiled with avx2 enabled. It is only called after ForwardKinematicSoA checked the cpu at runtime.
+
+#include "ForwardKinematicSoA_Kernel.hpp"
+
+#if defined(SHARED_AVX2_KERNEL)
+
+#include <immintrin.h>
+
+namespace Shared::ForwardKinematicSoA::Kernel
+{
+
+    struct AVX2_Lanes
+    {
+        using Type = __m256;
+        static constexpr int Width = 8;
+
+        static Type Set(float const value) { return _mm256_set1_ps(value); }
+        static Type Load(float const * ptr) { return _mm256_loadu_ps(ptr); }
+        static void Store(float * ptr, Type const value) { _mm256_storeu_ps(ptr, value); }
+        static Type Add(Type const a, Type const b) { return _mm256_add_ps(a, b); }
+        static Type Sub(Type const a, Type const b) { return _mm256_sub_ps(a, b); }
+        static Type Mul(Type const a, Type const b) { return _mm256_mul_ps(a, b); }
+        static Type Round(Type const a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    };
+
+    //-------------------------------------------------------------------------------------------------
+
+    void CalculateAVX2(Params const & params)
+    {
+        Calculate<AVX2_Lanes>(params);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+#pragma once
+
+// Private header of ForwardKinematicSoA. It is included by translation units that are compiled with different
+// instruction set flags, so it must not pull in any inline function that could be shared with the rest of the program.
+
+namespace Shared::ForwardKinematicSoA::Kernel
+{
+
+    struct Params
+    {
+        float const * lengths;
+        float const * anglesX;
+        float const * anglesY;
+        int jointCount;
+        int stride;
+        int laneCount;              // Multiple of the kernel width
+
+        float * outEndX;
+        float * outEndY;
+        float * outEndZ;
+
+        // Optional, receives the position of every joint end as [joint * stride + lane]
+        float * outJointX;
+        float * outJointY;
+        float * outJointZ;
+    };
+
+    // Sine and cosine of an angle in degree using only add/mul/round so every lane type can run it.
+    // The angle is wrapped to [-180, 180], evaluated at a quarter angle and doubled twice.
+    template<typename V>
+    inline void SinCosDegree(typename V::Type const degree, typename V::Type & outSin, typename V::Type & outCos)
+    {
+        using T = typename V::Type;
+        T const wrapped = V::Sub(degree, V::Mul(V::Round(V::Mul(degree, V::Set(1.0f / 360.0f))), V::Set(360.0f)));
+        T const x = V::Mul(wrapped, V::Set(3.14159265358979f / 720.0f));
+        T const x2 = V::Mul(x, x);
+
+        T s = V::Set(1.0f / 362880.0f);
+        s = V::Add(V::Mul(s, x2), V::Set(-1.0f / 5040.0f));
+        s = V::Add(V::Mul(s, x2), V::Set(1.0f / 120.0f));
+        s = V::Add(V::Mul(s, x2), V::Set(-1.0f / 6.0f));
+        s = V::Add(V::Mul(s, x2), V::Set(1.0f));
+        s = V::Mul(s, x);
+
+        T c = V::Set(-1.0f / 3628800.0f);
+        c = V::Add(V::Mul(c, x2), V::Set(1.0f / 40320.0f));
+        c = V::Add(V::Mul(c, x2), V::Set(-1.0f / 720.0f));
+        c = V::Add(V::Mul(c, x2), V::Set(1.0f / 24.0f));
+        c = V::Add(V::Mul(c, x2), V::Set(-0.5f));
+        c = V::Add(V::Mul(c, x2), V::Set(1.0f));
+
+        for (int i = 0; i < 2; i++)
+        {
+            T const s2 = V::Mul(V::Set(2.0f), V::Mul(s, c));
+            T const c2 = V::Sub(V::Mul(c, c), V::Mul(s, s));
+            s = s2;
+            c = c2;
+        }
+
+        outSin = s;
+        outCos = c;
+    }
+
+    // Same math as ForwardKinematic::Calculate with the rotation kept as a 3x3 matrix and the position as a vector.
+    // Each joint multiplies by rotateY * rotateX and moves along the new up axis by its length.
+    template<typename V>
+    inline void Calculate(Params const & params)
+    {
+        using T = typename V::Type;
+
+        for (int lane = 0; lane < params.laneCount; lane += V::Width)
+        {
+            // Root is a 90 degree rotation around the x axis
+            T r00 = V::Set(1.0f), r10 = V::Set(0.0f), r20 = V::Set(0.0f);
+            T r01 = V::Set(0.0f), r11 = V::Set(0.0f), r21 = V::Set(1.0f);
+            T r02 = V::Set(0.0f), r12 = V::Set(-1.0f), r22 = V::Set(0.0f);
+            T px = V::Set(0.0f), py = V::Set(0.0f), pz = V::Set(0.0f);
+
+            for (int joint = 0; joint < params.jointCount; joint++)
+            {
+                int const idx = joint * params.stride + lane;
+
+                T sa, ca, sb, cb;
+                SinCosDegree<V>(V::Load(params.anglesX + idx), sa, ca);
+                SinCosDegree<V>(V::Load(params.anglesY + idx), sb, cb);
+
+                // Columns of rotateY(b) * rotateX(a)
+                T const m0x = cb, m0z = V::Sub(V::Set(0.0f), sb);
+                T const m1x = V::Mul(sb, sa), m1y = ca, m1z = V::Mul(cb, sa);
+                T const m2x = V::Mul(sb, ca), m2y = V::Sub(V::Set(0.0f), sa), m2z = V::Mul(cb, ca);
+
+                T const n00 = V::Add(V::Mul(r00, m0x), V::Mul(r02, m0z));
+                T const n10 = V::Add(V::Mul(r10, m0x), V::Mul(r12, m0z));
+                T const n20 = V::Add(V::Mul(r20, m0x), V::Mul(r22, m0z));
+
+                T const n01 = V::Add(V::Add(V::Mul(r00, m1x), V::Mul(r01, m1y)), V::Mul(r02, m1z));
+                T const n11 = V::Add(V::Add(V::Mul(r10, m1x), V::Mul(r11, m1y)), V::Mul(r12, m1z));
+                T const n21 = V::Add(V::Add(V::Mul(r20, m1x), V::Mul(r21, m1y)), V::Mul(r22, m1z));
+
+                T const n02 = V::Add(V::Add(V::Mul(r00, m2x), V::Mul(r01, m2y)), V::Mul(r02, m2z));
+                T const n12 = V::Add(V::Add(V::Mul(r10, m2x), V::Mul(r11, m2y)), V::Mul(r12, m2z));
+                T const n22 = V::Add(V::Add(V::Mul(r20, m2x), V::Mul(r21, m2y)), V::Mul(r22, m2z));
+
+                r00 = n00; r10 = n10; r20 = n20;
+                r01 = n01; r11 = n11; r21 = n21;
+                r02 = n02; r12 = n12; r22 = n22;
+
+                T const length = V::Load(params.lengths + idx);
+                px = V::Add(px, V::Mul(r01, length));
+                py = V::Add(py, V::Mul(r11, length));
+                pz = V::Add(pz, V::Mul(r21, length));
+
+                if (params.outJointX != nullptr)
+                {
+                    V::Store(params.outJointX + idx, px);
+                    V::Store(params.outJointY + idx, py);
+                    V::Store(params.outJointZ + idx, pz);
+                }
+            }
+
+            V::Store(params.outEndX + lane, px);
+            V::Store(params.outEndY + lane, py);
+            V::Store(params.outEndZ + lane, pz);
+        }
+    }
+
+    void CalculateScalar(Params const & params);
+
+    void CalculateAVX2(Params const & params);
+
+    void CalculateNEON(Params const & params);
+
+}
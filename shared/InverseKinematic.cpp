@@ -1,5 +1,1239 @@
 #include "InverseKinematic.hpp"
 
+#include "CCD_Solver.hpp"
+#include "Dual.hpp"
+#include "FABRIK_Solver.hpp"
+#include "FixedChainSolver.hpp"
+#include "ForwardKinematic.hpp"
+#include "ReachabilityMap.hpp"
+#include "TwoBoneSolver.hpp"
+
+#include "BedrockMath.hpp"
+
 namespace Shared
 {
-}
\ No newline at end of file
+
+    using namespace MFA;
+
+    //-------------------------------------------------------------------------------------------------
+
+    namespace
+    {
+
+        glm::vec3 & TargetPosition(glm::vec3 & target)
+        {
+            return target;
+        }
+
+        glm::vec3 & TargetPosition(InverseKinematic::PoseTarget & target)
+        {
+            return target.position;
+        }
+
+        // Orientation of the last joint
+        glm::quat EndOrientation(KinematicChain const & chain)
+        {
+            return glm::quat_cast(glm::mat3(chain.WorldMatrix(chain.JointCount() - 1)));
+        }
+
+        // Weighted residual of the end point (and orientation for 6 rows). The unweighted errors go to the result.
+        template<int Rows>
+        void EvaluateResidual(
+            KinematicChain const & chain,
+            InverseKinematic::PoseTarget const & target,
+            InverseKinematic::Residual<Rows> & outResidual,
+            InverseKinematic::Result & outResult
+        )
+        {
+            outResult.endPoint = chain.EndPoint();
+            auto const positionError = target.position - outResult.endPoint;
+            outResult.error = glm::length(positionError);
+            auto const weightedPosition = positionError * target.positionWeight;
+            outResidual.template head<3>() << weightedPosition.x, weightedPosition.y, weightedPosition.z;
+
+            if constexpr (Rows == 6)
+            {
+                auto const rotationError = InverseKinematic::OrientationError(EndOrientation(chain), target.orientation);
+                outResult.orientationError = glm::length(rotationError);
+                auto const weightedRotation = rotationError * target.orientationWeight;
+                outResidual.template tail<3>() << weightedRotation.x, weightedRotation.y, weightedRotation.z;
+            }
+        }
+
+        // Largest of the weighted position error and the weighted orientation error in radian
+        template<int Rows>
+        float ResidualError(InverseKinematic::Residual<Rows> const & residual)
+        {
+            float error = residual.template head<3>().norm();
+            if constexpr (Rows == 6)
+            {
+                error = std::max(error, residual.template tail<3>().norm());
+            }
+            return error;
+        }
+
+        template<int Rows>
+        void WeightRows(InverseKinematic::PoseTarget const & target, Eigen::MatrixX<float> & J)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                J.row(row) *= target.positionWeight[row];
+            }
+            if constexpr (Rows == 6)
+            {
+                for (int row = 0; row < 3; row++)
+                {
+                    J.row(3 + row) *= target.orientationWeight[row];
+                }
+            }
+        }
+
+        // Geometric jacobian of the end point and, with orientation, of the end frame rotation
+        template<bool WithOrientation>
+        void FillAnalyticJacobian(
+            KinematicChain const & chain,
+            Eigen::MatrixX<float> & outJacobian,
+            uint8_t const * activeMasks
+        )
+        {
+            // Angles are stored in degree so angular columns are scaled by d(radian)/d(degree)
+            static constexpr float degreeToRadian = glm::pi<float>() / 180.0f;
+
+            auto const jointCount = chain.JointCount();
+            outJacobian.resize(WithOrientation ? 6 : 3, jointCount * DOF_PerJoint);
+
+            glm::vec3 const endPoint = chain.EndPoint();
+
+            for (int i = 0; i < jointCount; i++)
+            {
+                auto const & joint = chain.GetJoint(i);
+                auto const mask = activeMasks != nullptr ? activeMasks[i] : ActiveDOF_Mask(joint);
+                if (mask == 0)
+                {
+                    outJacobian.middleCols<DOF_PerJoint>(i * DOF_PerJoint).setZero();
+                    continue;
+                }
+
+                glm::mat3 const parent = chain.ParentMatrix(i);
+                auto const toEnd = endPoint - chain.Pivot(i);
+
+                // The x axis is rotated by the y rotation of the same joint
+                float const yRadian = glm::radians(joint.angle.y);
+                glm::vec3 const axisY = parent * Math::UpVec3;
+                glm::vec3 const axisX = parent * glm::vec3{std::cos(yRadian), 0.0f, -std::sin(yRadian)};
+                glm::vec3 const direction = glm::mat3(chain.WorldMatrix(i)) * Math::UpVec3;
+
+                glm::vec3 const columns[DOF_PerJoint]
+                {
+                    (mask & LengthBit) == 0 ? glm::vec3{} : direction,
+                    (mask & X_AngleBit) == 0 ? glm::vec3{} : glm::cross(axisX, toEnd) * degreeToRadian,
+                    (mask & Y_AngleBit) == 0 ? glm::vec3{} : glm::cross(axisY, toEnd) * degreeToRadian,
+                };
+                for (int dof = 0; dof < DOF_PerJoint; dof++)
+                {
+                    outJacobian(0, DOF_PerJoint * i + dof) = columns[dof].x;
+                    outJacobian(1, DOF_PerJoint * i + dof) = columns[dof].y;
+                    outJacobian(2, DOF_PerJoint * i + dof) = columns[dof].z;
+                }
+
+                if constexpr (WithOrientation)
+                {
+                    // Changing the length does not rotate the end frame, an angle rotates it around its axis
+                    glm::vec3 const angularColumns[DOF_PerJoint]
+                    {
+                        glm::vec3{},
+                        (mask & X_AngleBit) == 0 ? glm::vec3{} : axisX * degreeToRadian,
+                        (mask & Y_AngleBit) == 0 ? glm::vec3{} : axisY * degreeToRadian,
+                    };
+                    for (int dof = 0; dof < DOF_PerJoint; dof++)
+                    {
+                        outJacobian(3, DOF_PerJoint * i + dof) = angularColumns[dof].x;
+                        outJacobian(4, DOF_PerJoint * i + dof) = angularColumns[dof].y;
+                        outJacobian(5, DOF_PerJoint * i + dof) = angularColumns[dof].z;
+                    }
+                }
+            }
+        }
+
+        // Jacobian of the point at t along the bone (0 is its pivot, 1 its end), one column per DOF of the bone and
+        // its parents
+        void PointJacobian(
+            KinematicChain const & chain,
+            int const bone,
+            float const t,
+            uint8_t const * activeMasks,
+            Eigen::Matrix<float, 3, Eigen::Dynamic> & outJacobian
+        )
+        {
+            static constexpr float degreeToRadian = glm::pi<float>() / 180.0f;
+
+            glm::vec3 const boneEnd = chain.WorldMatrix(bone)[3];
+            glm::vec3 const point = glm::mix(chain.Pivot(bone), boneEnd, t);
+            outJacobian.resize(3, (bone + 1) * DOF_PerJoint);
+
+            for (int i = 0; i <= bone; i++)
+            {
+                auto const & joint = chain.GetJoint(i);
+                auto const mask = activeMasks[i];
+                glm::mat3 const parent = chain.ParentMatrix(i);
+                auto const toPoint = point - chain.Pivot(i);
+
+                float const yRadian = glm::radians(joint.angle.y);
+                glm::vec3 const axisY = parent * Math::UpVec3;
+                glm::vec3 const axisX = parent * glm::vec3{std::cos(yRadian), 0.0f, -std::sin(yRadian)};
+                glm::vec3 const direction = glm::mat3(chain.WorldMatrix(i)) * Math::UpVec3;
+
+                glm::vec3 const columns[DOF_PerJoint]
+                {
+                    (mask & LengthBit) == 0 ? glm::vec3{} : direction * (i == bone ? t : 1.0f),
+                    (mask & X_AngleBit) == 0 ? glm::vec3{} : glm::cross(axisX, toPoint) * degreeToRadian,
+                    (mask & Y_AngleBit) == 0 ? glm::vec3{} : glm::cross(axisY, toPoint) * degreeToRadian,
+                };
+                for (int dof = 0; dof < DOF_PerJoint; dof++)
+                {
+                    outJacobian.col(DOF_PerJoint * i + dof) << columns[dof].x, columns[dof].y, columns[dof].z;
+                }
+            }
+        }
+
+        // Joints whose DOFs share one dual number. The cost of a pass grows with the lane count times the joints it
+        // covers, so a single joint (3 lanes) per pass is the cheapest and wider passes were measured slower.
+        static constexpr int DualJointsPerPass = 1;
+        using JacobianDual = Dual<DualJointsPerPass * DOF_PerJoint>;
+
+        // Jacobian from dual number passes over the templated forward kinematic. Angles are seeded in degree so the
+        // columns come out in the same units as FillAnalyticJacobian.
+        template<bool WithOrientation>
+        void FillDualJacobian(
+            KinematicChain const & chain,
+            Eigen::MatrixX<float> & outJacobian,
+            uint8_t const * activeMasks
+        )
+        {
+            using Transform = ForwardKinematic::Transform<JacobianDual>;
+            using JointValues = ForwardKinematic::JointValues<JacobianDual>;
+
+            auto const jointCount = chain.JointCount();
+            outJacobian.resize(WithOrientation ? 6 : 3, jointCount * DOF_PerJoint);
+
+            for (int begin = 0; begin < jointCount; begin += DualJointsPerPass)
+            {
+                int const end = std::min(begin + DualJointsPerPass, jointCount);
+
+                bool hasActiveDOF = false;
+                for (int i = begin; i < end; i++)
+                {
+                    hasActiveDOF |= (activeMasks != nullptr ? activeMasks[i] : ActiveDOF_Mask(chain.GetJoint(i))) != 0;
+                }
+                if (hasActiveDOF == false)
+                {
+                    outJacobian.middleCols(begin * DOF_PerJoint, (end - begin) * DOF_PerJoint).setZero();
+                    continue;
+                }
+
+                auto const getJoint = [&](int const index)->JointValues
+                {
+                    auto const & joint = chain.GetJoint(index);
+                    auto const mask = activeMasks != nullptr ? activeMasks[index] : ActiveDOF_Mask(joint);
+                    int const lane = (index - begin) * DOF_PerJoint;
+                    float const values[DOF_PerJoint] {joint.length, joint.angle.x, joint.angle.y};
+                    JacobianDual duals[DOF_PerJoint] {};
+                    for (int dof = 0; dof < DOF_PerJoint; dof++)
+                    {
+                        duals[dof] = (mask & (1 << dof)) != 0
+                            ? JacobianDual::Variable(values[dof], lane + dof)
+                            : JacobianDual{values[dof]};
+                    }
+                    return JointValues{duals[0], duals[1], duals[2]};
+                };
+
+                Transform const transform = ForwardKinematic::CalculateTransform(
+                    ForwardKinematic::ToTransform<JacobianDual>(chain.ParentMatrix(begin)),
+                    begin,
+                    end,
+                    getJoint
+                );
+
+                // The joints after the pass are constant: endPoint = position + rotation * tail
+                glm::vec3 const tail = end < jointCount ? glm::vec3(chain.SuffixMatrix(end)[3]) : glm::vec3{};
+                auto const & r = transform.rotation;
+
+                for (int lane = 0; lane < (end - begin) * DOF_PerJoint; lane++)
+                {
+                    auto const column = begin * DOF_PerJoint + lane;
+                    for (int row = 0; row < 3; row++)
+                    {
+                        outJacobian(row, column) = transform.position[row].derivative[lane] +
+                            r[0][row].derivative[lane] * tail.x +
+                            r[1][row].derivative[lane] * tail.y +
+                            r[2][row].derivative[lane] * tail.z;
+                    }
+
+                    if constexpr (WithOrientation)
+                    {
+                        // The suffix rotation is constant so d(R_end) * R_end^T = dR * R^T = skew(angular velocity)
+                        auto const skew = [&r, lane](int const row, int const column)->float
+                        {
+                            float value = 0.0f;
+                            for (int k = 0; k < 3; k++)
+                            {
+                                value += r[k][row].derivative[lane] * r[k][column].value;
+                            }
+                            return value;
+                        };
+                        outJacobian(3, column) = skew(2, 1);
+                        outJacobian(4, column) = skew(0, 2);
+                        outJacobian(5, column) = skew(1, 0);
+                    }
+                }
+            }
+        }
+
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::InverseKinematic(Params const & params)
+        : _params(params)
+    {
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Result InverseKinematic::Solve(Chain & chain, glm::vec3 const & target) const
+    {
+        Workspace workspace{};
+        return Solve(chain, target, workspace);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Result InverseKinematic::Solve(Chain & chain, glm::vec3 const & target, Workspace & workspace) const
+    {
+        if (_params.reachability != nullptr)
+        {
+            auto const solve = [this, &workspace](Chain & seeded, glm::vec3 const & reachable)->Result
+            {
+                return SolvePosition(seeded, reachable, workspace);
+            };
+            return SolveReachable(chain, target, solve);
+        }
+        return SolvePosition(chain, target, workspace);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Result InverseKinematic::SolvePosition(
+        Chain & chain,
+        glm::vec3 const & target,
+        Workspace & workspace
+    ) const
+    {
+        // The closed form and position based solvers keep no state between solves, a warm start only applies to
+        // the damped least squares solvers
+        auto const endWarmStart = [&workspace]()->void
+        {
+            workspace.warmStart = false;
+            workspace.isJacobianReusable = false;
+        };
+
+        // The closed form solve stands in for the damped least squares loop only, a chosen FABRIK or CCD still runs
+        if (_params.method == Method::DampedLeastSquares &&
+            _params.useTwoBoneSolver == true &&
+            HasSecondaryObjectives() == false &&
+            HasCollisionQueries() == false &&
+            TwoBoneSolver::CanSolve(chain) == true)
+        {
+            endWarmStart();
+            Termination const termination(_params);
+            auto const * pole = _params.twoBonePole.has_value() == true ? &*_params.twoBonePole : nullptr;
+            auto result = TwoBoneSolver::Solve(chain, target, pole);
+            termination.Finish(result);
+            return result;
+        }
+
+        if (_params.method == Method::FABRIK)
+        {
+            endWarmStart();
+            return FABRIK_Solver::Solve(chain, target, _params, workspace);
+        }
+
+        if (_params.method == Method::CCD)
+        {
+            endWarmStart();
+            return CCD_Solver::Solve(chain, target, _params, workspace);
+        }
+
+        if (_params.useFixedChainSolvers == true &&
+            _params.jacobianMode == JacobianMode::Analytic &&
+            _params.linearSolver == LinearSolver::TaskSpace &&
+            _params.dampingMode != DampingMode::Selective &&
+            HasSecondaryObjectives() == false &&
+            HasCollisionQueries() == false)
+        {
+            auto const fixedSolver = FindFixedChainSolver(chain);
+            if (fixedSolver != nullptr)
+            {
+                return fixedSolver(chain.data(), target, _params, workspace);
+            }
+        }
+
+        return SolveDampedLeastSquares<3>(chain, PoseTarget{.position = target}, workspace);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Result InverseKinematic::Solve(Chain & chain, PoseTarget const & target, Workspace & workspace) const
+    {
+        if (_params.reachability != nullptr)
+        {
+            auto const solve = [this, &workspace](Chain & seeded, PoseTarget const & reachable)->Result
+            {
+                return SolveDampedLeastSquares<6>(seeded, reachable, workspace);
+            };
+            return SolveReachable(chain, target, solve);
+        }
+        return SolveDampedLeastSquares<6>(chain, target, workspace);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<typename Target, typename Solver>
+    InverseKinematic::Result InverseKinematic::SolveReachable(Chain & chain, Target target, Solver const & solve) const
+    {
+        auto const & map = *_params.reachability;
+        if (map.Matches(chain) == false)
+        {
+            return solve(chain, target);
+        }
+
+        auto & position = TargetPosition(target);
+        auto const requested = position;
+        auto const query = map.Find(requested);
+
+        if (query.isReachable == false && _params.rejectUnreachable == true)
+        {
+            Termination const termination(_params);
+            Result result{};
+            result.endPoint = ForwardKinematic::Calculate(chain);
+            result.error = glm::distance(result.endPoint, requested);
+            result.isReachable = false;
+            termination.Finish(result);
+            result.converged = false;
+            return result;
+        }
+
+        if (_params.seedFromReachability == true && query.seedIndex >= 0)
+        {
+            auto const endPoint = ForwardKinematic::Calculate(chain);
+            if (glm::distance(query.seedEndPoint, requested) < glm::distance(endPoint, requested))
+            {
+                map.ApplySeed(query.seedIndex, chain);
+            }
+        }
+
+        position = query.nearestReachable;
+        auto result = solve(chain, target);
+        if (query.isReachable == false)
+        {
+            result.error = glm::distance(result.endPoint, requested);
+            result.isReachable = false;
+            result.converged = false;
+        }
+        return result;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<int Rows>
+    InverseKinematic::Result InverseKinematic::SolveDampedLeastSquares(
+        Chain & chain,
+        PoseTarget const & target,
+        Workspace & workspace
+    ) const
+    {
+        Termination const termination(_params);
+
+        if (workspace.warmStart == false)
+        {
+            workspace.isJacobianReusable = false;
+        }
+        // A workspace that has not finished a solve yet has no damping to carry over
+        if (workspace.warmStart == false || workspace.damping <= 0.0f)
+        {
+            workspace.damping = _params.damping;
+        }
+        workspace.warmStart = false;
+
+        for (auto & joint : chain)
+        {
+            ClampToLimits(joint);
+        }
+
+        auto & kinematicChain = workspace.chain;
+        kinematicChain.Assign(chain);
+        kinematicChain.Update();
+
+        Result result{};
+        Residual<Rows> residual{};
+        EvaluateResidual<Rows>(kinematicChain, target, residual, result);
+
+        if (chain.empty() == true)
+        {
+            termination.Finish(result);
+            result.converged = ResidualError<Rows>(residual) <= _params.tolerance;
+            return result;
+        }
+
+        auto & J = workspace.J;
+        auto & dTheta = workspace.dTheta;
+
+        AdaptiveDamping damping(_params, workspace.damping);
+
+        // The jacobian of the previous solve is one small step away from the warm started pose. It only seeds the
+        // first step, isJacobianAtPose tells whether J was evaluated at the current pose and may outlive a rejection.
+        bool isJacobianCurrent = workspace.isJacobianReusable == true &&
+            J.rows() == Rows &&
+            J.cols() == static_cast<Eigen::Index>(chain.size()) * DOF_PerJoint;
+        bool isJacobianAtPose = false;
+        bool isLastStepRejected = false;
+
+        // DOFs that the solver may change. A DOF whose step gets clamped by its limit is frozen and its jacobian
+        // column is no longer evaluated for the rest of the solve.
+        auto & activeMasks = workspace.activeMasks;
+        activeMasks.resize(chain.size());
+        bool hasFrozenDOF = false;
+        auto const releaseFrozenDOFs = [&]()->void
+        {
+            for (int i = 0; i < (int)chain.size(); i++)
+            {
+                activeMasks[i] = ActiveDOF_Mask(kinematicChain.GetJoint(i));
+            }
+            hasFrozenDOF = false;
+        };
+        releaseFrozenDOFs();
+
+        // Lengths the minimal length change objective pulls toward
+        auto & referenceLengths = workspace.referenceLengths;
+        referenceLengths.resize(chain.size());
+        for (size_t i = 0; i < chain.size(); i++)
+        {
+            referenceLengths[i] = _params.restPose.size() == chain.size() ? _params.restPose[i].length : chain[i].length;
+        }
+        workspace.secondaryScale = 1.0f;
+        workspace.selfCollisionPairs = 0;
+        workspace.selfCollisionUs = 0.0f;
+
+        // Projects the step into the joint limits and writes the applied step back to dTheta
+        auto const applyStep = [&]()->void
+        {
+            for (int i = 0; i < (int)chain.size(); i++)
+            {
+                auto joint = kinematicChain.GetJoint(i);
+                float * values[DOF_PerJoint] {&joint.length, &joint.angle.x, &joint.angle.y};
+                for (int dof = 0; dof < DOF_PerJoint; dof++)
+                {
+                    auto const column = i * DOF_PerJoint + dof;
+                    if ((activeMasks[i] & (1 << dof)) == 0)
+                    {
+                        dTheta(column) = 0.0f;
+                        continue;
+                    }
+                    float const value = std::clamp(*values[dof] + dTheta(column), joint.minLimit[dof], joint.maxLimit[dof]);
+                    if (value != *values[dof] + dTheta(column))
+                    {
+                        activeMasks[i] &= ~(1 << dof);
+                        hasFrozenDOF = true;
+                    }
+                    dTheta(column) = value - *values[dof];
+                    *values[dof] = value;
+                }
+                kinematicChain.SetJoint(i, joint);
+            }
+            kinematicChain.Update();
+        };
+
+        auto const revertStep = [&]()->void
+        {
+            for (int i = 0; i < (int)chain.size(); i++)
+            {
+                auto joint = kinematicChain.GetJoint(i);
+                joint.length -= dTheta(i * DOF_PerJoint + 0);
+                joint.angle.x -= dTheta(i * DOF_PerJoint + 1);
+                joint.angle.y -= dTheta(i * DOF_PerJoint + 2);
+                kinematicChain.SetJoint(i, joint);
+            }
+            kinematicChain.Update();
+        };
+
+        // A bone inside an obstacle keeps the solve going after the target is reached so the repulsion can act
+        workspace.isPenetrating = false;
+        if (_params.obstacles != nullptr && _params.obstacleWeight > 0.0f && HasSecondaryObjectives() == true)
+        {
+            workspace.contacts.clear();
+            _params.obstacles->FindContacts(
+                kinematicChain,
+                _params.boneRadius,
+                0.0f,
+                workspace.contacts,
+                workspace.obstacleCandidates
+            );
+            workspace.isPenetrating = workspace.contacts.empty() == false;
+        }
+        if (_params.avoidSelfCollision == true && _params.selfCollisionWeight > 0.0f)
+        {
+            FindSelfContacts(workspace);
+            for (auto const & contact : workspace.selfContacts)
+            {
+                workspace.isPenetrating |= contact.depth > _params.selfCollisionClearance;
+            }
+        }
+
+        for (int iteration = 0; iteration < _params.maxIterations; iteration++)
+        {
+            float const error = workspace.isPenetrating == true
+                ? std::numeric_limits<float>::max()
+                : ResidualError<Rows>(residual);
+            if (termination.ShouldStop(error))
+            {
+                break;
+            }
+            result.iterations = iteration + 1;
+
+            bool const isJacobianChanged = isJacobianCurrent == false;
+            if (isJacobianChanged == true)
+            {
+                if constexpr (Rows == 6)
+                {
+                    if (_params.jacobianMode == JacobianMode::Dual)
+                    {
+                        DualPoseJacobian(kinematicChain, J, activeMasks.data());
+                    }
+                    else
+                    {
+                        AnalyticPoseJacobian(kinematicChain, J, activeMasks.data());
+                    }
+                }
+                else if (_params.jacobianMode == JacobianMode::Analytic)
+                {
+                    AnalyticJacobian(kinematicChain, J, activeMasks.data());
+                }
+                else if (_params.jacobianMode == JacobianMode::Dual)
+                {
+                    DualJacobian(kinematicChain, J, activeMasks.data());
+                }
+                else
+                {
+                    Jacobian(kinematicChain, J, activeMasks.data());
+                }
+                WeightRows<Rows>(target, J);
+                isJacobianAtPose = true;
+            }
+            isJacobianCurrent = false;
+            isLastStepRejected = false;
+
+            workspace.damping = damping.GetDamping();
+            Residual<Rows> const dE = residual;
+            CalculateStep<Rows>(dE, workspace, isJacobianChanged);
+
+            applyStep();
+            Result next = result;
+            EvaluateResidual<Rows>(kinematicChain, target, residual, next);
+
+            if (_params.dampingMode == DampingMode::Adaptive)
+            {
+                Residual<Rows> const predicted = dE - J * dTheta;
+                if (damping.Update(dE.squaredNorm(), residual.squaredNorm(), predicted.squaredNorm()) == false)
+                {
+                    // The error grew, step back and retry with a larger damping. The jacobian can be kept if it
+                    // was evaluated at this pose and no frozen DOFs are released, they may be what blocks the
+                    // progress. A jacobian carried over from the previous solve is stale and may be the reason the
+                    // step failed, so it is evaluated again instead.
+                    // The null space step is only exact to first order, near the target its drift alone can be
+                    // what makes the error grow, so it is halved with every rejection.
+                    revertStep();
+                    residual = dE;
+                    workspace.secondaryScale *= 0.5f;
+                    isLastStepRejected = true;
+                    if (hasFrozenDOF == true)
+                    {
+                        releaseFrozenDOFs();
+                    }
+                    else
+                    {
+                        isJacobianCurrent = isJacobianAtPose == true;
+                    }
+                    continue;
+                }
+            }
+
+            // Less than a tenth off the error means the secondary objectives are pulling against the target
+            if (residual.squaredNorm() > 0.81f * dE.squaredNorm())
+            {
+                workspace.secondaryScale *= 0.5f;
+            }
+
+            result.endPoint = next.endPoint;
+            result.error = next.error;
+            result.orientationError = next.orientationError;
+            isJacobianAtPose = false;
+        }
+        workspace.damping = damping.GetDamping();
+
+        chain = kinematicChain.GetJoints();
+        // A solve that ended on a rejection would hand the jacobian that just failed to the next solve
+        workspace.isJacobianReusable = result.iterations > 0 && isLastStepRejected == false;
+
+        if (_params.obstacles != nullptr)
+        {
+            workspace.contacts.clear();
+            _params.obstacles->FindContacts(
+                kinematicChain,
+                _params.boneRadius,
+                0.0f,
+                workspace.contacts,
+                workspace.obstacleCandidates
+            );
+            result.collisionCount = static_cast<int>(workspace.contacts.size());
+        }
+        if (_params.avoidSelfCollision == true)
+        {
+            FindSelfContacts(workspace);
+            for (auto const & contact : workspace.selfContacts)
+            {
+                result.selfCollisionCount += contact.depth > _params.selfCollisionClearance ? 1 : 0;
+            }
+            result.selfCollisionPairs = workspace.selfCollisionPairs;
+            result.selfCollisionUs = workspace.selfCollisionUs;
+        }
+
+        termination.Finish(result);
+        result.converged = ResidualError<Rows>(residual) <= _params.tolerance;
+        return result;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<int Rows>
+    void InverseKinematic::CalculateStep(
+        Residual<Rows> const & dE,
+        Workspace & workspace,
+        bool const isJacobianChanged
+    ) const
+    {
+        auto const & J = workspace.J;
+        auto & dTheta = workspace.dTheta;
+        auto const columnCount = static_cast<int>(J.cols());
+
+        if (_params.dampingMode == DampingMode::Selective)
+        {
+            CalculateSelectivelyDampedStep<Rows>(dE, workspace);
+            return;
+        }
+
+        if (_params.linearSolver == LinearSolver::JointSpace)
+        {
+            // dTheta = (JT * J + damping * I)^-1 * JT * dE
+            auto & JTxJ = workspace.JTxJ;
+            auto & JTxE = workspace.JTxE;
+            if (isJacobianChanged == true || workspace.factorizationDamping != workspace.damping)
+            {
+                JTxJ.noalias() = J.transpose() * J;
+                JTxJ.diagonal().array() += workspace.damping;
+                workspace.ldlt.compute(JTxJ);
+                workspace.factorizationDamping = workspace.damping;
+            }
+            JTxE.noalias() = J.transpose() * dE;
+            dTheta = workspace.ldlt.solve(JTxE);
+
+            if (HasSecondaryObjectives() == true)
+            {
+                // N * z = z - (JT * J + damping * I)^-1 * JT * J * z, reusing the factorization
+                auto const & z = workspace.nullSpaceStep;
+                CalculateSecondaryStep(workspace);
+                Residual<Rows> Jz{};
+                Jz.noalias() = J * z;
+                JTxE.noalias() = J.transpose() * Jz;
+                dTheta += z;
+                dTheta -= workspace.ldlt.solve(JTxE);
+            }
+            return;
+        }
+
+        // dTheta = JT * (J * JT + damping * I)^-1 * dE
+        // J * JT is accumulated column by column and the (rows x rows) system lives on the stack so nothing is
+        // allocated.
+        Eigen::Matrix<float, Rows, Rows> JxJT = Eigen::Matrix<float, Rows, Rows>::Identity() * workspace.damping;
+        for (int column = 0; column < columnCount; column++)
+        {
+            Residual<Rows> const c = J.col(column);
+            JxJT.noalias() += c * c.transpose();
+        }
+        Eigen::LDLT<Eigen::Matrix<float, Rows, Rows>> const ldlt(JxJT);
+        Residual<Rows> const y = ldlt.solve(dE);
+
+        dTheta.resize(columnCount);
+        for (int column = 0; column < columnCount; column++)
+        {
+            dTheta(column) = J.col(column).dot(y);
+        }
+
+        if (HasSecondaryObjectives() == true)
+        {
+            // N * z = z - JT * (J * JT + damping * I)^-1 * J * z, one more solve with the same factorization
+            auto const & z = workspace.nullSpaceStep;
+            CalculateSecondaryStep(workspace);
+            Residual<Rows> Jz{};
+            Jz.noalias() = J * z;
+            Residual<Rows> const yz = ldlt.solve(Jz);
+            for (int column = 0; column < columnCount; column++)
+            {
+                dTheta(column) += z(column) - J.col(column).dot(yz);
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void InverseKinematic::CalculatePositionStep(glm::vec3 const & error, Workspace & workspace) const
+    {
+        workspace.damping = _params.damping;
+        if (HasSecondaryObjectives() == true)
+        {
+            // The secondary step reads the state a solve sets up before its first iteration
+            auto const jointCount = workspace.chain.JointCount();
+            workspace.activeMasks.resize(jointCount);
+            workspace.referenceLengths.resize(jointCount);
+            for (int i = 0; i < jointCount; i++)
+            {
+                auto const & joint = workspace.chain.GetJoint(i);
+                workspace.activeMasks[i] = ActiveDOF_Mask(joint);
+                workspace.referenceLengths[i] = _params.restPose.size() == static_cast<size_t>(jointCount)
+                    ? _params.restPose[i].length
+                    : joint.length;
+            }
+            workspace.secondaryScale = 1.0f;
+        }
+        CalculateStep<3>(Residual<3>{error.x, error.y, error.z}, workspace, true);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool InverseKinematic::HasSecondaryObjectives() const
+    {
+        return (_params.restPoseWeight > 0.0f && _params.restPose.empty() == false) ||
+            _params.limitAvoidanceWeight > 0.0f ||
+            _params.lengthChangeWeight > 0.0f ||
+            (_params.obstacles != nullptr && _params.obstacleWeight > 0.0f) ||
+            (_params.avoidSelfCollision == true && _params.selfCollisionWeight > 0.0f);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool InverseKinematic::HasCollisionQueries() const
+    {
+        return _params.obstacles != nullptr || _params.avoidSelfCollision == true;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void InverseKinematic::CalculateSecondaryStep(Workspace & workspace) const
+    {
+        auto const & chain = workspace.chain;
+        auto const jointCount = chain.JointCount();
+        auto & z = workspace.nullSpaceStep;
+        z.setZero(jointCount * DOF_PerJoint);
+
+        bool const hasRestPose = _params.restPoseWeight > 0.0f &&
+            static_cast<int>(_params.restPose.size()) == jointCount;
+
+        for (int i = 0; i < jointCount; i++)
+        {
+            auto const & joint = chain.GetJoint(i);
+            auto const mask = workspace.activeMasks[i];
+            float const values[DOF_PerJoint] {joint.length, joint.angle.x, joint.angle.y};
+
+            for (int dof = 0; dof < DOF_PerJoint; dof++)
+            {
+                if ((mask & (1 << dof)) == 0)
+                {
+                    continue;
+                }
+                auto const column = i * DOF_PerJoint + dof;
+                float const value = values[dof];
+
+                if (hasRestPose == true)
+                {
+                    auto const & rest = _params.restPose[i];
+                    float const restValues[DOF_PerJoint] {rest.length, rest.angle.x, rest.angle.y};
+                    z(column) += _params.restPoseWeight * (restValues[dof] - value);
+                }
+
+                // Pulls toward the middle of the range, harder as the limit gets closer
+                float const min = joint.minLimit[dof];
+                float const max = joint.maxLimit[dof];
+                if (_params.limitAvoidanceWeight > 0.0f && std::isfinite(min) == true && std::isfinite(max) == true)
+                {
+                    float const middle = (min + max) * 0.5f;
+                    float const halfRange = std::max((max - min) * 0.5f, glm::epsilon<float>());
+                    float const closeness = (value - middle) / halfRange;
+                    z(column) += _params.limitAvoidanceWeight * (middle - value) * closeness * closeness;
+                }
+
+                if (dof == 0 && _params.lengthChangeWeight > 0.0f)
+                {
+                    z(column) += _params.lengthChangeWeight * (workspace.referenceLengths[i] - value);
+                }
+            }
+        }
+
+        // The decay of the secondary scale is meant for soft preferences, the repulsion keeps its full weight
+        z *= workspace.secondaryScale;
+
+        workspace.isPenetrating = false;
+        if (_params.obstacles != nullptr && _params.obstacleWeight > 0.0f)
+        {
+            // Each contact asks its closest bone point to move out by depth along the normal. The damped pseudo
+            // inverse of the 3 row point jacobian turns that into joint changes of the bone and its parents.
+            auto & contacts = workspace.contacts;
+            contacts.clear();
+            _params.obstacles->FindContacts(
+                chain,
+                _params.boneRadius,
+                _params.obstacleClearance,
+                contacts,
+                workspace.obstacleCandidates
+            );
+
+            auto & Jc = workspace.contactJacobian;
+            float const damping = std::max(workspace.damping, 1e-4f);
+            for (auto const & contact : contacts)
+            {
+                PointJacobian(chain, contact.bone, contact.t, workspace.activeMasks.data(), Jc);
+                Eigen::Matrix3f JcxJcT = Jc * Jc.transpose();
+                JcxJcT.diagonal().array() += damping;
+                auto const push = contact.normal * (contact.depth * _params.obstacleWeight);
+                Eigen::Vector3f const y = JcxJcT.ldlt().solve(Eigen::Vector3f{push.x, push.y, push.z});
+                z.head(Jc.cols()).noalias() += Jc.transpose() * y;
+
+                workspace.isPenetrating |= contact.depth > _params.obstacleClearance;
+            }
+        }
+
+        if (_params.avoidSelfCollision == true && _params.selfCollisionWeight > 0.0f)
+        {
+            // The same push for a pair of bones: the jacobian of the gap between the closest points is the point
+            // jacobian of boneB minus the one of boneA, whose columns are a prefix of it.
+            FindSelfContacts(workspace);
+
+            auto & Jc = workspace.contactJacobian;
+            auto & Ja = workspace.selfContactJacobian;
+            float const damping = std::max(workspace.damping, 1e-4f);
+            for (auto const & contact : workspace.selfContacts)
+            {
+                PointJacobian(chain, contact.boneB, contact.tB, workspace.activeMasks.data(), Jc);
+                PointJacobian(chain, contact.boneA, contact.tA, workspace.activeMasks.data(), Ja);
+                Jc.leftCols(Ja.cols()) -= Ja;
+                Eigen::Matrix3f JcxJcT = Jc * Jc.transpose();
+                JcxJcT.diagonal().array() += damping;
+                auto const push = contact.normal * (contact.depth * _params.selfCollisionWeight);
+                Eigen::Vector3f const y = JcxJcT.ldlt().solve(Eigen::Vector3f{push.x, push.y, push.z});
+                z.head(Jc.cols()).noalias() += Jc.transpose() * y;
+
+                workspace.isPenetrating |= contact.depth > _params.selfCollisionClearance;
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void InverseKinematic::FindSelfContacts(Workspace & workspace) const
+    {
+        workspace.selfContacts.clear();
+        workspace.selfCollision.FindContacts(
+            workspace.chain,
+            _params.boneRadius,
+            _params.selfCollisionClearance,
+            workspace.selfContacts
+        );
+        auto const & statistics = workspace.selfCollision.GetStatistics();
+        workspace.selfCollisionPairs += statistics.candidatePairs;
+        workspace.selfCollisionUs += statistics.elapsedUs;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<int Rows>
+    void InverseKinematic::CalculateSelectivelyDampedStep(Residual<Rows> const & dE, Workspace & workspace)
+    {
+        // Buss and Kim, selectively damped least squares. Each singular direction of J gets its own clamp on the
+        // joint change, so directions close to a singularity are damped while well conditioned ones take full steps.
+        // Angles are in degree so the clamp is in degree as well.
+        static constexpr float maxStep = 45.0f;
+        static constexpr float singularEpsilon = 1e-12f;
+
+        auto const & J = workspace.J;
+        auto & dTheta = workspace.dTheta;
+        auto const columnCount = static_cast<int>(J.cols());
+
+        // Singular values and left singular vectors of J from the (rows x rows) J * JT
+        Eigen::Matrix<float, Rows, Rows> JxJT = Eigen::Matrix<float, Rows, Rows>::Zero();
+        for (int column = 0; column < columnCount; column++)
+        {
+            Residual<Rows> const c = J.col(column);
+            JxJT.noalias() += c * c.transpose();
+        }
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix<float, Rows, Rows>> const eigenSolver(JxJT);
+
+        dTheta.setZero(columnCount);
+        for (int i = 0; i < Rows; i++)
+        {
+            float const sigmaSquared = eigenSolver.eigenvalues()(i);
+            if (sigmaSquared <= singularEpsilon)
+            {
+                continue;
+            }
+            float const sigma = std::sqrt(sigmaSquared);
+            Residual<Rows> const u = eigenSolver.eigenvectors().col(i);
+            float const alpha = u.dot(dE);
+            // N: size of u summed over the position and orientation blocks
+            float responseNorm = 1.0f;
+            if constexpr (Rows == 6)
+            {
+                responseNorm = u.template head<3>().norm() + u.template tail<3>().norm();
+            }
+
+            // v = JT * u / sigma is the matching right singular vector
+            float jointChange = 0.0f;           // M: joint change needed to move the end point by one unit along u
+            float maxAbs = 0.0f;
+            for (int column = 0; column < columnCount; column++)
+            {
+                float const v = J.col(column).dot(u) / sigma;
+                jointChange += std::abs(v) * J.col(column).norm();
+                maxAbs = std::max(maxAbs, std::abs(alpha / sigma * v));
+            }
+            jointChange /= sigma;
+
+            float const gamma = jointChange > responseNorm ? maxStep * responseNorm / jointChange : maxStep;
+            float const scale = alpha / sigma * (maxAbs > gamma ? gamma / maxAbs : 1.0f);
+            for (int column = 0; column < columnCount; column++)
+            {
+                dTheta(column) += scale * J.col(column).dot(u) / sigma;
+            }
+        }
+
+        float const maxAbs = dTheta.cwiseAbs().maxCoeff();
+        if (maxAbs > maxStep)
+        {
+            dTheta *= maxStep / maxAbs;
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void InverseKinematic::SolveBatch(
+        Chain const & chain,
+        std::vector<glm::vec3> const & targets,
+        std::vector<Joint> & outJoints,
+        std::vector<Result> * outResults
+    ) const
+    {
+        SolveBatchImpl(chain, targets, outJoints, outResults);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void InverseKinematic::SolveBatch(
+        Chain const & chain,
+        std::vector<PoseTarget> const & targets,
+        std::vector<Joint> & outJoints,
+        std::vector<Result> * outResults
+    ) const
+    {
+        SolveBatchImpl(chain, targets, outJoints, outResults);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<typename Target>
+    void InverseKinematic::SolveBatchImpl(
+        Chain const & chain,
+        std::vector<Target> const & targets,
+        std::vector<Joint> & outJoints,
+        std::vector<Result> * outResults
+    ) const
+    {
+        auto const jointCount = chain.size();
+        outJoints.resize(targets.size() * jointCount);
+        if (outResults != nullptr)
+        {
+            outResults->resize(targets.size());
+        }
+
+        Chain scratch{};
+        Workspace workspace{};
+        for (size_t targetIdx = 0; targetIdx < targets.size(); targetIdx++)
+        {
+            scratch = chain;
+            auto const result = Solve(scratch, targets[targetIdx], workspace);
+            std::copy(scratch.begin(), scratch.end(), outJoints.begin() + targetIdx * jointCount);
+            if (outResults != nullptr)
+            {
+                (*outResults)[targetIdx] = result;
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void InverseKinematic::Jacobian(
+        KinematicChain const & chain,
+        Eigen::MatrixX<float> & outJacobian,
+        uint8_t const * activeMasks
+    )
+    {
+        // The epsilon here determines the convergence rate and thus the speed
+        static constexpr float lengthEpsilon = 0.025f;
+        static constexpr float angleEpsilon = 0.5f;
+
+        auto const jointCount = chain.JointCount();
+        outJacobian.resize(3, jointCount * DOF_PerJoint);
+        for (int armIdx = 0; armIdx < jointCount; armIdx++)
+        {
+            auto const centralDifference = [&chain, armIdx](int const dof, bool const isFixed, float const epsilon)->glm::vec3
+            {
+                if (isFixed == true)
+                {
+                    return {};
+                }
+                auto prevJoint = chain.GetJoint(armIdx);
+                auto nextJoint = prevJoint;
+                float * prevValues[DOF_PerJoint] {&prevJoint.length, &prevJoint.angle.x, &prevJoint.angle.y};
+                float * nextValues[DOF_PerJoint] {&nextJoint.length, &nextJoint.angle.x, &nextJoint.angle.y};
+                *prevValues[dof] -= epsilon;
+                *nextValues[dof] += epsilon;
+                glm::vec3 const prevEndPoint = chain.PerturbedEndPoint(armIdx, prevJoint);
+                glm::vec3 const nextEndPoint = chain.PerturbedEndPoint(armIdx, nextJoint);
+                return (nextEndPoint - prevEndPoint) / (2.0f * epsilon);
+            };
+
+            auto const mask = activeMasks != nullptr ? activeMasks[armIdx] : ActiveDOF_Mask(chain.GetJoint(armIdx));
+            glm::vec3 const columns[DOF_PerJoint]
+            {
+                centralDifference(0, (mask & LengthBit) == 0, lengthEpsilon),
+                centralDifference(1, (mask & X_AngleBit) == 0, angleEpsilon),
+                centralDifference(2, (mask & Y_AngleBit) == 0, angleEpsilon),
+            };
+            for (int dof = 0; dof < DOF_PerJoint; dof++)
+            {
+                outJacobian(0, DOF_PerJoint * armIdx + dof) = columns[dof].x;
+                outJacobian(1, DOF_PerJoint * armIdx + dof) = columns[dof].y;
+                outJacobian(2, DOF_PerJoint * armIdx + dof) = columns[dof].z;
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void InverseKinematic::AnalyticJacobian(
+        KinematicChain const & chain,
+        Eigen::MatrixX<float> & outJacobian,
+        uint8_t const * activeMasks
+    )
+    {
+        FillAnalyticJacobian<false>(chain, outJacobian, activeMasks);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void InverseKinematic::AnalyticPoseJacobian(
+        KinematicChain const & chain,
+        Eigen::MatrixX<float> & outJacobian,
+        uint8_t const * activeMasks
+    )
+    {
+        FillAnalyticJacobian<true>(chain, outJacobian, activeMasks);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void InverseKinematic::DualJacobian(
+        KinematicChain const & chain,
+        Eigen::MatrixX<float> & outJacobian,
+        uint8_t const * activeMasks
+    )
+    {
+        FillDualJacobian<false>(chain, outJacobian, activeMasks);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void InverseKinematic::DualPoseJacobian(
+        KinematicChain const & chain,
+        Eigen::MatrixX<float> & outJacobian,
+        uint8_t const * activeMasks
+    )
+    {
+        FillDualJacobian<true>(chain, outJacobian, activeMasks);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::vec3 InverseKinematic::OrientationError(glm::quat const & current, glm::quat const & target)
+    {
+        // q and -q are the same rotation, take the short way around
+        auto const aligned = glm::dot(current, target) < 0.0f ? -target : target;
+        float const angle = Math::UnSignedAngle(current, aligned);
+        if (angle <= glm::epsilon<float>())
+        {
+            return {};
+        }
+        return glm::axis(aligned * glm::conjugate(current)) * angle;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::PoseTarget InverseKinematic::PoseTarget::Aim(glm::vec3 const & position, glm::vec3 const & direction)
+    {
+        // Rotates the rest direction of the chain onto the direction with the smallest possible turn
+        glm::mat3 const rest = ForwardKinematic::RootMatrix();
+        auto const rotation = Math::FindRotation(rest * Math::UpVec3, direction);
+        return PoseTarget {
+            .position = position,
+            .orientation = rotation * glm::quat_cast(rest),
+        };
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool InverseKinematic::ValidateJacobian(Chain const & chain, float const tolerance)
+    {
+        KinematicChain const kinematicChain(chain);
+        Eigen::MatrixX<float> numeric{};
+        Jacobian(kinematicChain, numeric);
+        Eigen::MatrixX<float> analytic{};
+        AnalyticJacobian(kinematicChain, analytic);
+        Eigen::MatrixX<float> dual{};
+        DualJacobian(kinematicChain, dual);
+        float const scale = std::max(1.0f, numeric.cwiseAbs().maxCoeff());
+        return (numeric - analytic).cwiseAbs().maxCoeff() <= tolerance * scale &&
+            (dual - analytic).cwiseAbs().maxCoeff() <= tolerance * scale;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Params const & InverseKinematic::GetParams() const
+    {
+        return _params;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void InverseKinematic::SetParams(Params const & params)
+    {
+        _params = params;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
@@ -1,14 +1,412 @@
 #pragma once
 
+#include "Joint.hpp"
+#include "KinematicChain.hpp"
+#include "ObstacleBVH.hpp"
+#include "SelfCollision.hpp"
+
+#include <Eigen>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <optional>
+
 namespace Shared
 {
 
-class InverseKinematic
-{
-public:
+    class ReachabilityMap;
+
+    // Headless damped least squares solver. It has no dependency on the renderer so it can be used by tools and servers.
+    class InverseKinematic
+    {
+    public:
+
+        enum class JacobianMode
+        {
+            FiniteDifference,           // 6 forward kinematic passes per joint
+            Analytic,                   // Geometric jacobian from joint axes, single forward kinematic pass
+            Dual,                       // Forward mode automatic differentiation, exact for any joint model
+        };
+
+        // Both forms give the same step: (JT * J + damping * I)^-1 * JT = JT * (J * JT + damping * I)^-1
+        enum class LinearSolver
+        {
+            JointSpace,                 // Factors the (3n x 3n) JT * J + damping * I, cubic in joint count
+            TaskSpace,                  // Factors the (3 x 3) J * JT + damping * I, linear in joint count
+        };
+
+        enum class Method
+        {
+            DampedLeastSquares,         // Jacobian based, handles every DOF
+            FABRIK,                     // Forward and backward reaching on joint positions, suited to long chains
+            CCD,                        // Cyclic coordinate descent, one closed form angle update per joint axis
+        };
+
+        enum class DampingMode
+        {
+            Fixed,                      // Params::damping is used as is
+            Adaptive,                   // Levenberg-Marquardt, damping follows the ratio of actual to predicted improvement
+            Selective,                  // Selectively damped least squares, every singular direction is damped on its own
+        };
+
+        struct Params
+        {
+            Method method = Method::DampedLeastSquares;
+            float damping = 0.25f;      // Acts as lambda^2 of the damped least squares, initial value for Adaptive
+            DampingMode dampingMode = DampingMode::Adaptive;
+            float minDamping = 1e-6f;   // Bounds of the Adaptive damping
+            float maxDamping = 1e4f;
+            JacobianMode jacobianMode = JacobianMode::Analytic;
+            LinearSolver linearSolver = LinearSolver::TaskSpace;
+            // Two joint chains with only free angles are solved in closed form by TwoBoneSolver when the method is
+            // DampedLeastSquares
+            bool useTwoBoneSolver = true;
+            // World space point the elbow of the two bone solve bends toward, the current bend is kept without one
+            std::optional<glm::vec3> twoBonePole{};
+            // Short chains with a uniform DOF mask are routed to a FixedChainSolver specialization when the
+            // linearSolver is TaskSpace
+            bool useFixedChainSolvers = true;
+            // Upper bound of jacobian steps per Solve call
+            int maxIterations = 1;
+            // Solve stops early once the end point is closer than this to the target
+            float tolerance = 0.0f;
+            // Wall clock budget of a single Solve call in microseconds, 0 means unlimited
+            float timeBudgetUs = 0.0f;
+            // Optional flag owned by the caller. Setting it from another thread stops the solve before its next step,
+            // RestartSolver uses it to cancel the restarts that are no longer needed.
+            std::atomic<bool> const * cancel = nullptr;
+            // Optional map built for the rig. A target it cannot reach is moved to the closest reachable point before
+            // iterating, or rejected without iterating when rejectUnreachable is set. seedFromReachability starts the
+            // solve from the sampled pose of the target voxel when that pose ends closer to the target than the
+            // chain does. Ignored for chains that do not match the map.
+            ReachabilityMap const * reachability = nullptr;
+            bool rejectUnreachable = false;
+            bool seedFromReachability = false;
+            // Optional obstacles. Bones are capsules of boneRadius, a bone closer than obstacleClearance to an obstacle
+            // gets a repulsion step that is projected into the null space like the secondary objectives. Only bones
+            // the BVH reports as near add work. While a bone intersects an obstacle the solve keeps iterating after
+            // reaching the target. Used by the Fixed and Adaptive damping modes.
+            ObstacleBVH const * obstacles = nullptr;
+            float boneRadius = 0.1f;
+            float obstacleClearance = 0.1f;
+            float obstacleWeight = 0.5f;        // Fraction of the contact depth removed per step
+            // Keeps bones that do not share a joint apart, with the same boneRadius. Pairs come from a spatial hash
+            // that is updated incrementally between iterations. Penetrating pairs keep the solve going like obstacles
+            // do, in the same damping modes.
+            bool avoidSelfCollision = false;
+            float selfCollisionClearance = 0.1f;
+            float selfCollisionWeight = 0.5f;   // Fraction of the contact depth removed per step
+            // Secondary objectives of redundant chains. Their step is projected into the null space of the jacobian
+            // so it never moves the end point. Each weight is the fraction of the offset that is removed per step.
+            // Only the Fixed and Adaptive damping modes use them.
+            Chain restPose{};               // Same joint count as the chain, empty disables the rest pose objective
+            float restPoseWeight = 0.0f;
+            float limitAvoidanceWeight = 0.0f;  // Toward the middle of finite joint limits
+            float lengthChangeWeight = 0.0f;    // Toward the rest pose length, or the length at the start of the solve
+        };
+
+        // End point position and orientation target. The orientation is the world rotation of the last joint.
+        struct PoseTarget
+        {
+            glm::vec3 position {};
+            glm::quat orientation = glm::identity<glm::quat>();
+            // Residual rows are scaled by these, a zero weight leaves that axis free
+            glm::vec3 positionWeight {1.0f};
+            glm::vec3 orientationWeight {1.0f};
+
+            // Target whose end bone points along the direction, the twist around it is the smallest turn from rest
+            [[nodiscard]]
+            static PoseTarget Aim(glm::vec3 const & position, glm::vec3 const & direction);
+        };
+
+        template<int Rows>
+        using Residual = Eigen::Matrix<float, Rows, 1>;
+
+        struct Result
+        {
+            glm::vec3 endPoint {};
+            float error {};                 // Distance between the end point and the target after solving
+            float orientationError {};      // Pose targets only, angle in radian to the target orientation
+            int iterations {};
+            bool converged = false;         // Weighted error is within the tolerance
+            float elapsedUs {};
+            bool isReachable = true;        // False if the reachability map moved or rejected the target
+            int collisionCount {};          // Bone and obstacle pairs that still intersect, Params::obstacles only
+            // Params::avoidSelfCollision only
+            int selfCollisionCount {};      // Bone pairs that still intersect
+            int selfCollisionPairs {};      // Candidate pairs the spatial hash sent to the narrow phase, all iterations
+            float selfCollisionUs {};       // Time spent in the self collision search, all iterations
+        };
+
+        // Decides when an iterative solve has to stop based on the tolerance and the time budget
+        class Termination
+        {
+        public:
+
+            explicit Termination(Params const & params)
+                : _tolerance(params.tolerance)
+                , _timeBudgetUs(params.timeBudgetUs)
+                , _cancel(params.cancel)
+                , _start(std::chrono::steady_clock::now())
+            {
+            }
+
+            // Returns true if no other step should be taken
+            [[nodiscard]]
+            bool ShouldStop(float const error) const
+            {
+                if (error <= _tolerance)
+                {
+                    return true;
+                }
+                if (_cancel != nullptr && _cancel->load(std::memory_order_relaxed) == true)
+                {
+                    return true;
+                }
+                return _timeBudgetUs > 0.0f && ElapsedUs() >= _timeBudgetUs;
+            }
+
+            [[nodiscard]]
+            float ElapsedUs() const
+            {
+                return std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - _start).count();
+            }
+
+            void Finish(Result & result) const
+            {
+                result.converged = result.error <= _tolerance;
+                result.elapsedUs = ElapsedUs();
+            }
+
+        private:
+
+            float _tolerance;
+            float _timeBudgetUs;
+            std::atomic<bool> const * _cancel;
+            std::chrono::steady_clock::time_point _start;
+
+        };
+
+        // Nielsen's Levenberg-Marquardt update. A step that lowers the error as the linear model predicts shrinks the
+        // damping toward Gauss-Newton, a step that raises the error is rejected and grows it toward gradient descent.
+        class AdaptiveDamping
+        {
+        public:
+
+            explicit AdaptiveDamping(Params const & params, float const damping)
+                : _minDamping(params.minDamping)
+                , _maxDamping(params.maxDamping)
+                , _damping(std::clamp(damping, params.minDamping, params.maxDamping))
+            {
+            }
+
+            // Returns false if the step has to be reverted
+            [[nodiscard]]
+            bool Update(float const errorSquared, float const newErrorSquared, float const predictedErrorSquared)
+            {
+                float const actualReduction = errorSquared - newErrorSquared;
+                float const predictedReduction = errorSquared - predictedErrorSquared;
+                if (actualReduction > 0.0f && predictedReduction > 0.0f)
+                {
+                    float const t = 2.0f * actualReduction / predictedReduction - 1.0f;
+                    _damping = std::max(_damping * std::max(1.0f / 3.0f, 1.0f - t * t * t), _minDamping);
+                    _growth = 2.0f;
+                    return true;
+                }
+                _damping = std::min(_damping * _growth, _maxDamping);
+                _growth *= 2.0f;
+                return false;
+            }
+
+            [[nodiscard]]
+            float GetDamping() const
+            {
+                return _damping;
+            }
+
+        private:
+
+            float _minDamping;
+            float _maxDamping;
+            float _damping;
+            float _growth = 2.0f;
+
+        };
+
+        // Scratch buffers of a solve. Reusing the same workspace for chains of the same length does not allocate,
+        // so each worker thread should own one.
+        struct Workspace
+        {
+            KinematicChain chain{};
+            Eigen::MatrixX<float> J{};
+            Eigen::VectorX<float> dTheta{};
+            // Joint space
+            Eigen::MatrixX<float> JTxJ{};
+            Eigen::VectorX<float> JTxE{};
+            Eigen::LDLT<Eigen::MatrixX<float>> ldlt{};
+            // Position based solvers
+            std::vector<glm::vec3> positions{};
+            std::vector<float> boneLengths{};
+            std::vector<glm::mat3> rotations{};
+            // DOFs that are neither fixed nor frozen at a joint limit
+            std::vector<uint8_t> activeMasks{};
+            // Secondary objectives
+            Eigen::VectorX<float> nullSpaceStep{};
+            std::vector<float> referenceLengths{};
+            float secondaryScale = 1.0f;        // Shrinks with every rejected step so the primary task can finish
+            // Obstacle avoidance
+            std::vector<ObstacleBVH::Contact> contacts{};
+            std::vector<int> obstacleCandidates{};
+            Eigen::Matrix<float, 3, Eigen::Dynamic> contactJacobian{};
+            bool isPenetrating = false;         // A bone intersected an obstacle at the last contact search
+            // Self collision avoidance
+            SelfCollision selfCollision{};
+            std::vector<SelfCollision::Contact> selfContacts{};
+            Eigen::Matrix<float, 3, Eigen::Dynamic> selfContactJacobian{};
+            int selfCollisionPairs {};
+            float selfCollisionUs {};
+            // Warm start state. SolutionCache sets warmStart before a solve to keep the fields below from the
+            // previous solve of the same rig, a plain Solve resets them.
+            bool warmStart = false;
+            bool isJacobianReusable = false;    // J (and the joint space factorization) seed the first step
+            float damping {};                   // Adaptive damping state
+            float factorizationDamping = -1.0f; // Damping the joint space factorization was built with
+        };
+
+        explicit InverseKinematic(Params const & params);
+
+        // Modifies the chain in place so that its end point moves toward the target
+        Result Solve(Chain & chain, glm::vec3 const & target) const;
+
+        Result Solve(Chain & chain, glm::vec3 const & target, Workspace & workspace) const;
+
+        // 6 row position and orientation solve. Always runs the damped least squares loop, with the dual jacobian for
+        // JacobianMode::Dual and the analytic one otherwise (FiniteDifference has no pose variant and falls back to
+        // it), and stops once both the weighted position error and the weighted orientation error (radian) are within
+        // the tolerance.
+        Result Solve(Chain & chain, PoseTarget const & target, Workspace & workspace) const;
+
+        // Solves a copy of the chain for every target. outJoints is filled with targets.size() consecutive chains.
+        void SolveBatch(
+            Chain const & chain,
+            std::vector<glm::vec3> const & targets,
+            std::vector<Joint> & outJoints,
+            std::vector<Result> * outResults = nullptr
+        ) const;
+
+        void SolveBatch(
+            Chain const & chain,
+            std::vector<PoseTarget> const & targets,
+            std::vector<Joint> & outJoints,
+            std::vector<Result> * outResults = nullptr
+        ) const;
+
+        // Central finite difference jacobian of the end point. Each probe reuses the cached prefix and suffix
+        // transforms so the whole jacobian costs O(n) instead of O(n^2).
+        // activeMasks holds a DOF_Bit mask per joint, columns outside of it are zero and not evaluated.
+        // nullptr means ActiveDOF_Mask of every joint.
+        static void Jacobian(
+            KinematicChain const & chain,
+            Eigen::MatrixX<float> & outJacobian,
+            uint8_t const * activeMasks = nullptr
+        );
+
+        // Exact jacobian built from the world space axis and pivot of each joint
+        static void AnalyticJacobian(
+            KinematicChain const & chain,
+            Eigen::MatrixX<float> & outJacobian,
+            uint8_t const * activeMasks = nullptr
+        );
+
+        // 6 row jacobian, the end point rows followed by the angular velocity rows of the end frame
+        static void AnalyticPoseJacobian(
+            KinematicChain const & chain,
+            Eigen::MatrixX<float> & outJacobian,
+            uint8_t const * activeMasks = nullptr
+        );
+
+        // Exact jacobian from forward mode automatic differentiation of ForwardKinematic::CalculateTransform.
+        // Each pass seeds the DOFs of a joint as dual number lanes, starts from the cached parent transform and
+        // finishes with the cached suffix transform, so the whole jacobian still costs O(n).
+        static void DualJacobian(
+            KinematicChain const & chain,
+            Eigen::MatrixX<float> & outJacobian,
+            uint8_t const * activeMasks = nullptr
+        );
+
+        // 6 row form of DualJacobian, the angular rows come from the derivative of the end rotation
+        static void DualPoseJacobian(
+            KinematicChain const & chain,
+            Eigen::MatrixX<float> & outJacobian,
+            uint8_t const * activeMasks = nullptr
+        );
+
+        // Writes one damped least squares step for the end point error into workspace.dTheta, using the damping
+        // mode, linear solver and damping of the params. workspace.J must hold the jacobian of workspace.chain.
+        // Solve runs the same code, this entry point lets the linear solve be timed on its own.
+        void CalculatePositionStep(glm::vec3 const & error, Workspace & workspace) const;
+
+        // Rotation vector (axis * angle in radian) that turns current onto target, the orientation residual
+        [[nodiscard]]
+        static glm::vec3 OrientationError(glm::quat const & current, glm::quat const & target);
+
+        // Returns true if the analytic, dual and finite difference jacobians match within the relative tolerance
+        [[nodiscard]]
+        static bool ValidateJacobian(Chain const & chain, float tolerance = 1e-2f);
+
+        [[nodiscard]]
+        Params const & GetParams() const;
+
+        void SetParams(Params const & params);
+
+    private:
+
+        // Position solve once the target is known to be reachable, picks the solver from the params
+        Result SolvePosition(Chain & chain, glm::vec3 const & target, Workspace & workspace) const;
+
+        // Moves the target into Params::reachability (or rejects it) and seeds the chain before calling solve.
+        // The result of a moved target reports its error to the requested target and is never converged.
+        template<typename Target, typename Solver>
+        Result SolveReachable(Chain & chain, Target target, Solver const & solve) const;
+
+        // Damped least squares loop for a 3 row (position) or 6 row (pose) residual
+        template<int Rows>
+        Result SolveDampedLeastSquares(Chain & chain, PoseTarget const & target, Workspace & workspace) const;
+
+        // Writes the damped least squares step for the error into workspace.dTheta. J must be up to date.
+        // The joint space factorization is kept while J and the damping are unchanged.
+        template<int Rows>
+        void CalculateStep(Residual<Rows> const & dE, Workspace & workspace, bool isJacobianChanged) const;
+
+        [[nodiscard]]
+        bool HasSecondaryObjectives() const;
+
+        // True if the result has to report obstacle or self collision contacts, which only the damped least squares
+        // loop does
+        [[nodiscard]]
+        bool HasCollisionQueries() const;
+
+        // Writes the unprojected secondary objective step into workspace.nullSpaceStep
+        void CalculateSecondaryStep(Workspace & workspace) const;
+
+        // Fills workspace.selfContacts for the current pose and adds the search cost to the workspace totals
+        void FindSelfContacts(Workspace & workspace) const;
+
+        template<int Rows>
+        static void CalculateSelectivelyDampedStep(Residual<Rows> const & dE, Workspace & workspace);
+
+        template<typename Target>
+        void SolveBatchImpl(
+            Chain const & chain,
+            std::vector<Target> const & targets,
+            std::vector<Joint> & outJoints,
+            std::vector<Result> * outResults
+        ) const;
 
-private:
+        Params _params{};
 
-};
+    };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Shared
+{
+
+    // 3 degrees of freedom per joint (Length + x, y angles)
+    static constexpr int DOF_PerJoint = 3;
+
+    struct Joint
+    {
+        float length = 3.0f;
+        glm::vec2 angle {};                 // In degree
+
+        bool isLengthFixed = true;
+        bool isX_AngleFixed = false;
+        bool isY_AngleFixed = false;
+
+        // Range of each DOF in the order length, x angle, y angle. Unlimited by default.
+        glm::vec3 minLimit {-std::numeric_limits<float>::infinity()};
+        glm::vec3 maxLimit {std::numeric_limits<float>::infinity()};
+
+        bool operator==(Joint const &) const = default;
+    };
+
+    using Chain = std::vector<Joint>;
+
+    enum DOF_Bit : uint8_t
+    {
+        LengthBit = 1 << 0,
+        X_AngleBit = 1 << 1,
+        Y_AngleBit = 1 << 2,
+        AllDOF_Bits = LengthBit | X_AngleBit | Y_AngleBit,
+    };
+
+    // Bit mask of the degrees of freedom that the solver is allowed to change
+    [[nodiscard]]
+    inline uint8_t ActiveDOF_Mask(Joint const & joint)
+    {
+        return (joint.isLengthFixed ? 0 : LengthBit) |
+            (joint.isX_AngleFixed ? 0 : X_AngleBit) |
+            (joint.isY_AngleFixed ? 0 : Y_AngleBit);
+    }
+
+    [[nodiscard]]
+    inline bool HasLimits(Joint const & joint)
+    {
+        return glm::all(glm::isinf(joint.minLimit)) == false || glm::all(glm::isinf(joint.maxLimit)) == false;
+    }
+
+    // Projects the free DOFs of the joint into their limits. Fixed DOFs are left as they are.
+    inline void ClampToLimits(Joint & joint)
+    {
+        if (joint.isLengthFixed == false)
+        {
+            joint.length = std::clamp(joint.length, joint.minLimit.x, joint.maxLimit.x);
+        }
+        if (joint.isX_AngleFixed == false)
+        {
+            joint.angle.x = std::clamp(joint.angle.x, joint.minLimit.y, joint.maxLimit.y);
+        }
+        if (joint.isY_AngleFixed == false)
+        {
+            joint.angle.y = std::clamp(joint.angle.y, joint.minLimit.z, joint.maxLimit.z);
+        }
+    }
+
+}
@@ -0,0 +1,176 @@
+#include "KinematicChain.hpp"
+
+#include "ForwardKinematic.hpp"
+
+#include "BedrockAssert.hpp"
+
+namespace Shared
+{
+
+    //-------------------------------------------------------------------------------------------------
+
+    KinematicChain::KinematicChain()
+        : _root(ForwardKinematic::RootMatrix())
+    {
+        _suffix.emplace_back(1.0f);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    KinematicChain::KinematicChain(Chain const & chain)
+        : KinematicChain()
+    {
+        Assign(chain);
+        Update();
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void KinematicChain::Assign(Chain const & chain)
+    {
+        auto const oldCount = JointCount();
+        auto const newCount = static_cast<int>(chain.size());
+
+        if (oldCount != newCount)
+        {
+            _joints.resize(newCount);
+            _local.resize(newCount);
+            _prefix.resize(newCount);
+            _suffix.resize(newCount + 1);
+            _suffix[newCount] = glm::mat4(1.0f);
+            for (int i = oldCount; i < newCount; i++)
+            {
+                _joints[i] = chain[i];
+                _local[i] = ForwardKinematic::JointMatrix(chain[i]);
+            }
+            // Changing the tail of the chain invalidates every suffix
+            _dirtyBegin = std::min(_dirtyBegin, std::min(oldCount, newCount));
+            _dirtyEnd = newCount;
+        }
+
+        for (int i = 0; i < std::min(oldCount, newCount); i++)
+        {
+            if (_joints[i] != chain[i])
+            {
+                SetJoint(i, chain[i]);
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void KinematicChain::SetJoint(int const index, Joint const & joint)
+    {
+        MFA_ASSERT(index >= 0 && index < JointCount());
+        _joints[index] = joint;
+        _local[index] = ForwardKinematic::JointMatrix(joint);
+        MarkDirty(index);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    Joint const & KinematicChain::GetJoint(int const index) const
+    {
+        return _joints[index];
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    Chain const & KinematicChain::GetJoints() const
+    {
+        return _joints;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int KinematicChain::JointCount() const
+    {
+        return static_cast<int>(_joints.size());
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void KinematicChain::Update()
+    {
+        auto const jointCount = JointCount();
+
+        for (int i = _dirtyBegin; i < jointCount; i++)
+        {
+            _prefix[i] = ParentMatrix(i) * _local[i];
+        }
+
+        for (int i = std::min(_dirtyEnd, jointCount) - 1; i >= 0; i--)
+        {
+            _suffix[i] = _local[i] * _suffix[i + 1];
+        }
+
+        _dirtyBegin = jointCount;
+        _dirtyEnd = 0;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool KinematicChain::IsDirty() const
+    {
+        return _dirtyBegin < JointCount() || _dirtyEnd > 0;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::mat4 const & KinematicChain::WorldMatrix(int const index) const
+    {
+        MFA_ASSERT(IsDirty() == false);
+        return _prefix[index];
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::mat4 const & KinematicChain::SuffixMatrix(int const index) const
+    {
+        MFA_ASSERT(IsDirty() == false);
+        return _suffix[index];
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::mat4 const & KinematicChain::ParentMatrix(int const index) const
+    {
+        return index > 0 ? _prefix[index - 1] : _root;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::vec3 KinematicChain::Pivot(int const index) const
+    {
+        return ParentMatrix(index)[3];
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::vec3 KinematicChain::EndPoint() const
+    {
+        MFA_ASSERT(IsDirty() == false);
+        return _joints.empty() ? glm::vec3(_root[3]) : glm::vec3(_prefix.back()[3]);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::vec3 KinematicChain::PerturbedEndPoint(int const index, Joint const & joint) const
+    {
+        MFA_ASSERT(IsDirty() == false);
+        // Parent * perturbed local * position of the end point relative to the next joint
+        glm::vec4 const tail = _suffix[index + 1][3];
+        return ParentMatrix(index) * (ForwardKinematic::JointMatrix(joint) * tail);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void KinematicChain::MarkDirty(int const index)
+    {
+        _dirtyBegin = std::min(_dirtyBegin, index);
+        _dirtyEnd = std::max(_dirtyEnd, index + 1);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Joint.hpp"
+
+namespace Shared
+{
+
+    // Caches the local, prefix (root -> joint) and suffix (joint -> end) transforms of a chain.
+    // Editing a joint only invalidates the prefixes after it and the suffixes before it, and the end point
+    // of a chain with a single perturbed joint can be evaluated with a constant number of multiplications.
+    class KinematicChain
+    {
+    public:
+
+        explicit KinematicChain();
+
+        explicit KinematicChain(Chain const & chain);
+
+        // Copies the chain and only marks the joints that differ from the cached ones as dirty
+        void Assign(Chain const & chain);
+
+        void SetJoint(int index, Joint const & joint);
+
+        [[nodiscard]]
+        Joint const & GetJoint(int index) const;
+
+        [[nodiscard]]
+        Chain const & GetJoints() const;
+
+        [[nodiscard]]
+        int JointCount() const;
+
+        // Recomputes dirty prefixes and suffixes
+        void Update();
+
+        [[nodiscard]]
+        bool IsDirty() const;
+
+        // World matrix of the joint (Root * L0 * ... * Li)
+        [[nodiscard]]
+        glm::mat4 const & WorldMatrix(int index) const;
+
+        // Product of the local matrices from the joint to the end of the chain (Li * ... * Ln-1)
+        [[nodiscard]]
+        glm::mat4 const & SuffixMatrix(int index) const;
+
+        // World matrix of the parent of the joint, the root matrix for the first joint
+        [[nodiscard]]
+        glm::mat4 const & ParentMatrix(int index) const;
+
+        [[nodiscard]]
+        glm::vec3 Pivot(int index) const;
+
+        [[nodiscard]]
+        glm::vec3 EndPoint() const;
+
+        // End point of the chain if the joint at index is replaced with the given one. Chain must be up to date.
+        [[nodiscard]]
+        glm::vec3 PerturbedEndPoint(int index, Joint const & joint) const;
+
+    private:
+
+        void MarkDirty(int index);
+
+        Chain _joints{};
+        std::vector<glm::mat4> _local{};
+        std::vector<glm::mat4> _prefix{};
+        std::vector<glm::mat4> _suffix{};        // One extra identity element at the end
+        glm::mat4 _root{};
+
+        // Prefixes in [_dirtyBegin, n) and suffixes in [0, _dirtyEnd) need to be recomputed
+        int _dirtyBegin {};
+        int _dirtyEnd {};
+
+    };
+
+}
@@ -0,0 +1,293 @@
+#include "ObstacleBVH.hpp"
+
+#include "BedrockAssert.hpp"
+#include "KinematicChain.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+
+namespace Shared
+{
+
+    //-------------------------------------------------------------------------------------------------
+
+    namespace
+    {
+
+        static constexpr int LeafSize = 4;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::vec2 ClosestPointsOfSegments(
+        glm::vec3 const & p1,
+        glm::vec3 const & q1,
+        glm::vec3 const & p2,
+        glm::vec3 const & q2
+    )
+    {
+        static constexpr float epsilon = 1e-8f;
+
+        auto const d1 = q1 - p1;
+        auto const d2 = q2 - p2;
+        auto const r = p1 - p2;
+        float const a = glm::dot(d1, d1);
+        float const e = glm::dot(d2, d2);
+        float const f = glm::dot(d2, r);
+
+        if (a <= epsilon && e <= epsilon)
+        {
+            return {};
+        }
+        if (a <= epsilon)
+        {
+            return {0.0f, std::clamp(f / e, 0.0f, 1.0f)};
+        }
+
+        float const c = glm::dot(d1, r);
+        if (e <= epsilon)
+        {
+            return {std::clamp(-c / a, 0.0f, 1.0f), 0.0f};
+        }
+
+        float const b = glm::dot(d1, d2);
+        float const denominator = a * e - b * b;
+        float s = denominator > epsilon ? std::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+        float t = (b * s + f) / e;
+        if (t < 0.0f)
+        {
+            t = 0.0f;
+            s = std::clamp(-c / a, 0.0f, 1.0f);
+        }
+        else if (t > 1.0f)
+        {
+            t = 1.0f;
+            s = std::clamp((b - c) / a, 0.0f, 1.0f);
+        }
+        return {s, t};
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int ObstacleBVH::AddSphere(Sphere const & sphere)
+    {
+        return AddCapsule(Capsule{.start = sphere.center, .end = sphere.center, .radius = sphere.radius});
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int ObstacleBVH::AddCapsule(Capsule const & capsule)
+    {
+        _obstacles.emplace_back(capsule);
+        _isDirty = true;
+        return static_cast<int>(_obstacles.size()) - 1;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ObstacleBVH::Clear()
+    {
+        _obstacles.clear();
+        _order.clear();
+        _nodes.clear();
+        _isDirty = false;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ObstacleBVH::Build()
+    {
+        auto const obstacleCount = static_cast<int>(_obstacles.size());
+        _order.resize(obstacleCount);
+        for (int i = 0; i < obstacleCount; i++)
+        {
+            _order[i] = i;
+        }
+        _nodes.clear();
+        _nodes.reserve(std::max(2 * obstacleCount / LeafSize + 1, 1));
+        if (obstacleCount > 0)
+        {
+            BuildNode(0, obstacleCount);
+        }
+        _isDirty = false;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int ObstacleBVH::BuildNode(int const first, int const count)
+    {
+        auto const nodeIdx = static_cast<int>(_nodes.size());
+        _nodes.emplace_back();
+
+        glm::vec3 min {std::numeric_limits<float>::max()};
+        glm::vec3 max {-std::numeric_limits<float>::max()};
+        glm::vec3 centerMin = min;
+        glm::vec3 centerMax = max;
+        for (int i = first; i < first + count; i++)
+        {
+            auto const & obstacle = _obstacles[_order[i]];
+            min = glm::min(min, glm::min(obstacle.start, obstacle.end) - obstacle.radius);
+            max = glm::max(max, glm::max(obstacle.start, obstacle.end) + obstacle.radius);
+            auto const center = (obstacle.start + obstacle.end) * 0.5f;
+            centerMin = glm::min(centerMin, center);
+            centerMax = glm::max(centerMax, center);
+        }
+        _nodes[nodeIdx].min = min;
+        _nodes[nodeIdx].max = max;
+
+        if (count <= LeafSize)
+        {
+            _nodes[nodeIdx].first = first;
+            _nodes[nodeIdx].count = count;
+            return nodeIdx;
+        }
+
+        auto const extent = centerMax - centerMin;
+        int axis = 0;
+        if (extent[1] > extent[axis])
+        {
+            axis = 1;
+        }
+        if (extent[2] > extent[axis])
+        {
+            axis = 2;
+        }
+
+        int const half = count / 2;
+        std::nth_element(
+            _order.begin() + first,
+            _order.begin() + first + half,
+            _order.begin() + first + count,
+            [this, axis](int const lhs, int const rhs)->bool
+            {
+                auto const & a = _obstacles[lhs];
+                auto const & b = _obstacles[rhs];
+                return a.start[axis] + a.end[axis] < b.start[axis] + b.end[axis];
+            }
+        );
+
+        // Children are built after the parent is stored, _nodes may reallocate so the parent is written by index
+        int const left = BuildNode(first, half);
+        int const right = BuildNode(first + half, count - half);
+        _nodes[nodeIdx].left = left;
+        _nodes[nodeIdx].right = right;
+        return nodeIdx;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int ObstacleBVH::ObstacleCount() const
+    {
+        return static_cast<int>(_obstacles.size());
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    ObstacleBVH::Capsule const & ObstacleBVH::GetObstacle(int const index) const
+    {
+        return _obstacles[index];
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ObstacleBVH::Query(
+        glm::vec3 const & start,
+        glm::vec3 const & end,
+        float const radius,
+        std::vector<int> & outObstacles
+    ) const
+    {
+        MFA_ASSERT(_isDirty == false);
+        if (_nodes.empty() == true)
+        {
+            return;
+        }
+
+        auto const min = glm::min(start, end) - radius;
+        auto const max = glm::max(start, end) + radius;
+
+        // The tree is balanced so 64 levels are never reached
+        int stack[64];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0)
+        {
+            auto const & node = _nodes[stack[--stackSize]];
+            if (glm::any(glm::lessThan(node.max, min)) || glm::any(glm::greaterThan(node.min, max)))
+            {
+                continue;
+            }
+            if (node.left < 0)
+            {
+                for (int i = node.first; i < node.first + node.count; i++)
+                {
+                    outObstacles.emplace_back(_order[i]);
+                }
+                continue;
+            }
+            stack[stackSize++] = node.left;
+            stack[stackSize++] = node.right;
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ObstacleBVH::FindContacts(
+        KinematicChain const & chain,
+        float const boneRadius,
+        float const clearance,
+        std::vector<Contact> & outContacts,
+        std::vector<int> & scratch
+    ) const
+    {
+        auto const jointCount = chain.JointCount();
+        for (int bone = 0; bone < jointCount; bone++)
+        {
+            glm::vec3 const start = chain.Pivot(bone);
+            glm::vec3 const end = chain.WorldMatrix(bone)[3];
+
+            scratch.clear();
+            Query(start, end, boneRadius + clearance, scratch);
+
+            for (auto const obstacleIdx : scratch)
+            {
+                auto const & obstacle = _obstacles[obstacleIdx];
+                auto const st = ClosestPointsOfSegments(start, end, obstacle.start, obstacle.end);
+                auto const onBone = start + (end - start) * st.x;
+                auto const onObstacle = obstacle.start + (obstacle.end - obstacle.start) * st.y;
+
+                auto const offset = onBone - onObstacle;
+                float const distance = glm::length(offset);
+                float const depth = obstacle.radius + boneRadius + clearance - distance;
+                if (depth <= 0.0f)
+                {
+                    continue;
+                }
+
+                Contact contact{};
+                contact.bone = bone;
+                contact.obstacle = obstacleIdx;
+                contact.t = st.x;
+                contact.depth = depth;
+                if (distance > glm::epsilon<float>())
+                {
+                    contact.normal = offset / distance;
+                }
+                else
+                {
+                    // The bone passes through the obstacle axis, push it sideways
+                    auto const axis = end - start;
+                    auto const side = glm::cross(axis, glm::vec3{0.0f, 1.0f, 0.0f});
+                    contact.normal = glm::length(side) > glm::epsilon<float>()
+                        ? glm::normalize(side)
+                        : glm::vec3{1.0f, 0.0f, 0.0f};
+                }
+                outContacts.emplace_back(contact);
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace Shared
+{
+
+    class KinematicChain;
+
+    // Closest points of the segments p1-q1 and p2-q2 (Ericson, Real-Time Collision Detection 5.1.9).
+    // Returns the parameter of each point along its segment.
+    [[nodiscard]]
+    glm::vec2 ClosestPointsOfSegments(
+        glm::vec3 const & p1,
+        glm::vec3 const & q1,
+        glm::vec3 const & p2,
+        glm::vec3 const & q2
+    );
+
+    // Sphere and capsule obstacles (the shapes ShapeRenderer draws) in a bounding volume hierarchy. A sphere is stored
+    // as a capsule with equal end points so the narrow phase is a single segment to segment distance.
+    // Queries only walk the nodes whose bounds overlap the query, so their cost follows the number of nearby
+    // obstacles instead of the total count.
+    class ObstacleBVH
+    {
+    public:
+
+        struct Sphere
+        {
+            glm::vec3 center {};
+            float radius {};
+        };
+
+        struct Capsule
+        {
+            glm::vec3 start {};
+            glm::vec3 end {};
+            float radius {};
+        };
+
+        // A bone closer to an obstacle than the requested clearance
+        struct Contact
+        {
+            int bone = -1;
+            int obstacle = -1;
+            float t {};                     // Closest point on the bone, 0 at its pivot and 1 at its end
+            glm::vec3 normal {};            // Unit direction that moves the bone away from the obstacle
+            float depth {};                 // How far the bone has to move to reach the clearance
+        };
+
+        // Returns the obstacle index. Build has to be called before the next query.
+        int AddSphere(Sphere const & sphere);
+
+        int AddCapsule(Capsule const & capsule);
+
+        void Clear();
+
+        // Rebuilds the hierarchy with a median split along the longest axis of every node
+        void Build();
+
+        [[nodiscard]]
+        int ObstacleCount() const;
+
+        [[nodiscard]]
+        Capsule const & GetObstacle(int index) const;
+
+        // Appends the obstacles whose bounds overlap the bounds of the capsule
+        void Query(glm::vec3 const & start, glm::vec3 const & end, float radius, std::vector<int> & outObstacles) const;
+
+        // Appends a contact for every bone (capsule of boneRadius) closer than clearance to an obstacle.
+        // scratch holds the broad phase candidates between calls so nothing is allocated once it has grown.
+        void FindContacts(
+            KinematicChain const & chain,
+            float boneRadius,
+            float clearance,
+            std::vector<Contact> & outContacts,
+            std::vector<int> & scratch
+        ) const;
+
+    private:
+
+        struct Node
+        {
+            glm::vec3 min {};
+            glm::vec3 max {};
+            int left = -1;                  // Inner node children, -1 for a leaf
+            int right = -1;
+            int first {};                   // Leaf range in _order
+            int count {};
+        };
+
+        int BuildNode(int first, int count);
+
+        std::vector<Capsule> _obstacles{};
+        std::vector<int> _order{};          // Obstacle indices grouped by leaf
+        std::vector<Node> _nodes{};
+        bool _isDirty = false;
+
+    };
+
+}
@@ -0,0 +1,173 @@
+#include "ParallelSolver.hpp"
+
+#include "BedrockAssert.hpp"
+#include "JobSystem.hpp"
+#include "TaskDispatch.hpp"
+
+#include <chrono>
+
+namespace Shared
+{
+
+    //-------------------------------------------------------------------------------------------------
+
+    ParallelSolver::ParallelSolver(InverseKinematic::Params const & params, int const workerCount)
+        : _solver(params)
+    {
+        SetWorkerCount(workerCount);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    std::future<void> ParallelSolver::Solve(
+        std::vector<Chain> & chains,
+        std::vector<glm::vec3> const & targets,
+        std::vector<InverseKinematic::Result> & outResults
+    )
+    {
+        return SolveImpl(chains, targets, outResults);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    std::future<void> ParallelSolver::Solve(
+        std::vector<Chain> & chains,
+        std::vector<InverseKinematic::PoseTarget> const & targets,
+        std::vector<InverseKinematic::Result> & outResults
+    )
+    {
+        return SolveImpl(chains, targets, outResults);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<typename Target>
+    std::future<void> ParallelSolver::SolveImpl(
+        std::vector<Chain> & chains,
+        std::vector<Target> const & targets,
+        std::vector<InverseKinematic::Result> & outResults
+    )
+    {
+        MFA_ASSERT(chains.size() == targets.size());
+
+        auto const chainCount = static_cast<int>(chains.size());
+        outResults.resize(chainCount);
+
+        int const taskCount = std::max(std::min(_workerCount, chainCount), 1);
+        int const chunkSize = (chainCount + taskCount - 1) / taskCount;
+
+        _runningTaskCount += taskCount;
+        return DispatchTasks(
+            taskCount,
+            [this, &chains, &targets, &outResults, chainCount, chunkSize](int const taskIdx)->void
+            {
+                // Counted down even when a solve throws
+                struct TaskScope
+                {
+                    std::atomic<int> & runningTaskCount;
+                    ~TaskScope() { --runningTaskCount; }
+                } const taskScope{_runningTaskCount};
+
+                int const begin = std::min(taskIdx * chunkSize, chainCount);
+                int const end = std::min(begin + chunkSize, chainCount);
+                auto & workspace = _workspaces[taskIdx];
+                for (int i = begin; i < end; i++)
+                {
+                    outResults[i] = _solver.Solve(chains[i], targets[i], workspace);
+                }
+            },
+            false
+        );
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    std::vector<ParallelSolver::ScalingSample> ParallelSolver::MeasureScaling(
+        std::vector<Chain> const & chains,
+        std::vector<glm::vec3> const & targets,
+        int maxWorkerCount
+    )
+    {
+        if (maxWorkerCount <= 0)
+        {
+            maxWorkerCount = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        }
+
+        auto const originalWorkerCount = _workerCount;
+
+        std::vector<ScalingSample> samples{};
+        std::vector<Chain> scratchChains{};
+        std::vector<InverseKinematic::Result> results{};
+
+        for (int workerCount = 1; workerCount <= maxWorkerCount; workerCount++)
+        {
+            SetWorkerCount(workerCount);
+            scratchChains = chains;
+
+            auto const start = std::chrono::high_resolution_clock::now();
+            Solve(scratchChains, targets, results).get();
+            auto const end = std::chrono::high_resolution_clock::now();
+
+            ScalingSample sample{};
+            sample.workerCount = workerCount;
+            sample.seconds = std::chrono::duration<double>(end - start).count();
+            sample.solvesPerSecond = sample.seconds > 0.0 ? static_cast<double>(chains.size()) / sample.seconds : 0.0;
+            sample.speedup = samples.empty() == false && sample.seconds > 0.0
+                ? samples.front().seconds / sample.seconds
+                : 1.0;
+            samples.emplace_back(sample);
+
+            MFA_LOG_INFO(
+                "IK scaling: %d workers, %f seconds, %f solves per second, %fx speedup",
+                sample.workerCount,
+                sample.seconds,
+                sample.solvesPerSecond,
+                sample.speedup
+            );
+        }
+
+        SetWorkerCount(originalWorkerCount);
+
+        return samples;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ParallelSolver::SetWorkerCount(int workerCount)
+    {
+        MFA_ASSERT(_runningTaskCount == 0);
+        if (workerCount <= 0)
+        {
+            workerCount = MFA::JobSystem::Instance != nullptr
+                ? MFA::JobSystem::Instance->NumberOfAvailableThreads()
+                : 1;
+        }
+        _workerCount = std::max(workerCount, 1);
+        _workspaces.resize(_workerCount);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int ParallelSolver::GetWorkerCount() const
+    {
+        return _workerCount;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic const & ParallelSolver::GetSolver() const
+    {
+        return _solver;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ParallelSolver::SetParams(InverseKinematic::Params const & params)
+    {
+        MFA_ASSERT(_runningTaskCount == 0);
+        _solver.SetParams(params);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "InverseKinematic.hpp"
+
+#include <atomic>
+#include <future>
+
+namespace Shared
+{
+
+    // Solves many independent chains by splitting them across MFA::JobSystem workers.
+    // Every worker owns a solver workspace so no scratch buffer is shared or reallocated between solves.
+    class ParallelSolver
+    {
+    public:
+
+        struct ScalingSample
+        {
+            int workerCount {};
+            double seconds {};
+            double solvesPerSecond {};
+            double speedup {};              // Relative to a single worker
+        };
+
+        // workerCount <= 0 means one worker per job system thread
+        explicit ParallelSolver(InverseKinematic::Params const & params, int workerCount = 0);
+
+        // Solves chains[i] toward targets[i] in place. The returned future is the single completion handle of the
+        // whole batch. chains, outResults and the solver must stay alive until it is ready.
+        [[nodiscard]]
+        std::future<void> Solve(
+            std::vector<Chain> & chains,
+            std::vector<glm::vec3> const & targets,
+            std::vector<InverseKinematic::Result> & outResults
+        );
+
+        [[nodiscard]]
+        std::future<void> Solve(
+            std::vector<Chain> & chains,
+            std::vector<InverseKinematic::PoseTarget> const & targets,
+            std::vector<InverseKinematic::Result> & outResults
+        );
+
+        // Solves copies of the chains with 1 to maxWorkerCount workers and reports the timing of each run.
+        // maxWorkerCount <= 0 means std::thread::hardware_concurrency.
+        [[nodiscard]]
+        std::vector<ScalingSample> MeasureScaling(
+            std::vector<Chain> const & chains,
+            std::vector<glm::vec3> const & targets,
+            int maxWorkerCount = 0
+        );
+
+        // Resizes the per worker workspaces, so it must not be called until the future of every Solve is ready
+        void SetWorkerCount(int workerCount);
+
+        [[nodiscard]]
+        int GetWorkerCount() const;
+
+        [[nodiscard]]
+        InverseKinematic const & GetSolver() const;
+
+        // Must not be called until the future of every Solve is ready either
+        void SetParams(InverseKinematic::Params const & params);
+
+    private:
+
+        template<typename Target>
+        std::future<void> SolveImpl(
+            std::vector<Chain> & chains,
+            std::vector<Target> const & targets,
+            std::vector<InverseKinematic::Result> & outResults
+        );
+
+        InverseKinematic _solver;
+        int _workerCount {};
+        std::vector<InverseKinematic::Workspace> _workspaces{};
+        std::atomic<int> _runningTaskCount {};     // Tasks of dispatched batches that did not finish yet
+
+    };
+
+}
@@ -0,0 +1,409 @@
+#include "ReachabilityMap.hpp"
+
+#include "BedrockAssert.hpp"
+#include "ForwardKinematic.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <queue>
+#include <random>
+
+namespace Shared
+{
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ReachabilityMap::Build(Chain const & chain, Params const & params)
+    {
+        MFA_ASSERT(params.resolution > 2);
+
+        _params = params;
+        _rig = chain;
+        _isBuilt = true;
+        _isUnbounded = false;
+        _occupiedCount = 0;
+        _nearestSeed.clear();
+        _distance.clear();
+        _seedValues.clear();
+        _seedEndPoints.clear();
+
+        // The end point can never be further from the base than the sum of the longest bone lengths
+        float reach = 0.0f;
+        for (auto const & joint : chain)
+        {
+            if (joint.isLengthFixed == true)
+            {
+                reach += std::abs(joint.length);
+            }
+            else if (std::isfinite(joint.minLimit.x) == true && std::isfinite(joint.maxLimit.x) == true)
+            {
+                reach += std::max(std::abs(joint.minLimit.x), std::abs(joint.maxLimit.x));
+            }
+            else
+            {
+                _isUnbounded = true;
+                return;
+            }
+        }
+        reach = std::max(reach, glm::epsilon<float>());
+
+        // One spare voxel on every side so the reach sphere never touches the border
+        auto const resolution = _params.resolution;
+        _voxelSize = 2.0f * reach / static_cast<float>(resolution - 2);
+        _origin = glm::vec3{-reach - _voxelSize};
+
+        auto const voxelCount = resolution * resolution * resolution;
+        _nearestSeed.assign(voxelCount, -1);
+        _distance.assign(voxelCount, std::numeric_limits<uint8_t>::max());
+
+        std::minstd_rand random(_params.seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        // Range a free DOF is sampled from, unlimited angles take a whole turn
+        auto const range = [](Joint const & joint, int const dof)->glm::vec2
+        {
+            float const min = joint.minLimit[dof];
+            float const max = joint.maxLimit[dof];
+            if (dof > 0 && (std::isfinite(min) == false || std::isfinite(max) == false))
+            {
+                return glm::vec2{-180.0f, 180.0f};
+            }
+            return glm::vec2{min, max};
+        };
+
+        auto const isFree = [](Joint const & joint, int const dof)->bool
+        {
+            return (ActiveDOF_Mask(joint) & (1 << dof)) != 0;
+        };
+
+        Chain pose = chain;
+        glm::vec3 previousEndPoint {};
+        for (int sample = 0; sample < _params.sampleCount; sample++)
+        {
+            bool const isWalkStart = sample % std::max(_params.walkLength, 1) == 0;
+            for (auto & joint : pose)
+            {
+                float * values[DOF_PerJoint] {&joint.length, &joint.angle.x, &joint.angle.y};
+                for (int dof = 0; dof < DOF_PerJoint; dof++)
+                {
+                    if (isFree(joint, dof) == false)
+                    {
+                        continue;
+                    }
+                    auto const bounds = range(joint, dof);
+                    if (isWalkStart == true)
+                    {
+                        *values[dof] = bounds.x + (bounds.y - bounds.x) * unit(random);
+                    }
+                    else
+                    {
+                        float const step = dof == 0 ? _params.lengthStep * reach : _params.angleStep;
+                        *values[dof] += (2.0f * unit(random) - 1.0f) * step;
+                    }
+                }
+                ClampToLimits(joint);
+            }
+
+            auto const endPoint = ForwardKinematic::Calculate(pose);
+            if (isWalkStart == true)
+            {
+                Record(ToVoxel(endPoint), pose, endPoint);
+            }
+            else
+            {
+                // Walk steps are small so the end point moves along a short curve, the voxels between two samples
+                // are reached as well
+                TraverseVoxels(previousEndPoint, endPoint, [&](glm::ivec3 const & voxel)->void
+                {
+                    Record(voxel, pose, endPoint);
+                });
+            }
+            previousEndPoint = endPoint;
+        }
+
+        _occupiedCount = static_cast<int>(_seedEndPoints.size());
+        PropagateDistances();
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool ReachabilityMap::IsBuilt() const
+    {
+        return _isBuilt;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool ReachabilityMap::Matches(Chain const & chain) const
+    {
+        if (_isBuilt == false || chain.size() != _rig.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < chain.size(); i++)
+        {
+            auto const & lhs = chain[i];
+            auto const & rhs = _rig[i];
+            if (lhs.isLengthFixed != rhs.isLengthFixed ||
+                lhs.isX_AngleFixed != rhs.isX_AngleFixed ||
+                lhs.isY_AngleFixed != rhs.isY_AngleFixed ||
+                lhs.minLimit != rhs.minLimit ||
+                lhs.maxLimit != rhs.maxLimit)
+            {
+                return false;
+            }
+            if ((lhs.isLengthFixed == true && lhs.length != rhs.length) ||
+                (lhs.isX_AngleFixed == true && lhs.angle.x != rhs.angle.x) ||
+                (lhs.isY_AngleFixed == true && lhs.angle.y != rhs.angle.y))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    ReachabilityMap::Query ReachabilityMap::Find(glm::vec3 const & target) const
+    {
+        Query query{};
+        query.nearestReachable = target;
+        if (_isBuilt == false || _isUnbounded == true || _occupiedCount == 0)
+        {
+            return query;
+        }
+
+        auto const voxel = ToVoxel(target);
+        auto const clampedVoxel = glm::clamp(voxel, glm::ivec3{0}, glm::ivec3{_params.resolution - 1});
+        auto const voxelIdx = VoxelIndex(clampedVoxel);
+
+        query.seedIndex = _nearestSeed[voxelIdx];
+        query.seedEndPoint = _seedEndPoints[query.seedIndex];
+        query.isReachable = voxel == clampedVoxel && static_cast<float>(_distance[voxelIdx]) <= _params.margin;
+        if (query.isReachable == false)
+        {
+            query.nearestReachable = query.seedEndPoint;
+        }
+        return query;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ReachabilityMap::ApplySeed(int const seedIndex, Chain & chain) const
+    {
+        MFA_ASSERT(seedIndex >= 0 && seedIndex < _occupiedCount);
+        MFA_ASSERT(chain.size() == _rig.size());
+
+        auto const * values = _seedValues.data() + static_cast<size_t>(seedIndex) * _rig.size();
+        for (size_t i = 0; i < chain.size(); i++)
+        {
+            auto & joint = chain[i];
+            if (joint.isLengthFixed == false)
+            {
+                joint.length = values[i].x;
+            }
+            if (joint.isX_AngleFixed == false)
+            {
+                joint.angle.x = values[i].y;
+            }
+            if (joint.isY_AngleFixed == false)
+            {
+                joint.angle.y = values[i].z;
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int ReachabilityMap::OccupiedVoxelCount() const
+    {
+        return _occupiedCount;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    float ReachabilityMap::VoxelSize() const
+    {
+        return _voxelSize;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    glm::ivec3 ReachabilityMap::ToVoxel(glm::vec3 const & position) const
+    {
+        return glm::ivec3{glm::floor((position - _origin) / _voxelSize)};
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int ReachabilityMap::VoxelIndex(glm::ivec3 const & voxel) const
+    {
+        auto const resolution = _params.resolution;
+        return (voxel.z * resolution + voxel.y) * resolution + voxel.x;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ReachabilityMap::Record(glm::ivec3 const & voxel, Chain const & pose, glm::vec3 const & endPoint)
+    {
+        if (glm::any(glm::lessThan(voxel, glm::ivec3{0})) ||
+            glm::any(glm::greaterThanEqual(voxel, glm::ivec3{_params.resolution})))
+        {
+            return;
+        }
+
+        auto const voxelIdx = VoxelIndex(voxel);
+        auto seedIndex = _nearestSeed[voxelIdx];
+
+        auto const center = _origin + (glm::vec3{voxel} + 0.5f) * _voxelSize;
+        if (seedIndex >= 0)
+        {
+            auto const & previous = _seedEndPoints[seedIndex];
+            if (glm::dot(previous - center, previous - center) <= glm::dot(endPoint - center, endPoint - center))
+            {
+                return;
+            }
+        }
+        else
+        {
+            seedIndex = static_cast<int>(_seedEndPoints.size());
+            _nearestSeed[voxelIdx] = seedIndex;
+            _distance[voxelIdx] = 0;
+            _seedEndPoints.emplace_back();
+            _seedValues.resize(_seedValues.size() + pose.size());
+        }
+
+        _seedEndPoints[seedIndex] = endPoint;
+        auto * values = _seedValues.data() + static_cast<size_t>(seedIndex) * pose.size();
+        for (size_t i = 0; i < pose.size(); i++)
+        {
+            values[i] = glm::vec3{pose[i].length, pose[i].angle.x, pose[i].angle.y};
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<typename Visitor>
+    void ReachabilityMap::TraverseVoxels(glm::vec3 const & start, glm::vec3 const & end, Visitor const & visitor) const
+    {
+        auto const from = (start - _origin) / _voxelSize;
+        auto const to = (end - _origin) / _voxelSize;
+        auto voxel = glm::ivec3{glm::floor(from)};
+        auto const lastVoxel = glm::ivec3{glm::floor(to)};
+        auto const direction = to - from;
+
+        glm::ivec3 step {};
+        glm::vec3 tMax {};
+        glm::vec3 tDelta {};
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (direction[axis] > 0.0f)
+            {
+                step[axis] = 1;
+                tDelta[axis] = 1.0f / direction[axis];
+                tMax[axis] = (static_cast<float>(voxel[axis]) + 1.0f - from[axis]) * tDelta[axis];
+            }
+            else if (direction[axis] < 0.0f)
+            {
+                step[axis] = -1;
+                tDelta[axis] = -1.0f / direction[axis];
+                tMax[axis] = (from[axis] - static_cast<float>(voxel[axis])) * tDelta[axis];
+            }
+            else
+            {
+                tDelta[axis] = std::numeric_limits<float>::infinity();
+                tMax[axis] = std::numeric_limits<float>::infinity();
+            }
+        }
+
+        // Rounding can make the walk miss the last voxel, it never needs more steps than the manhattan distance
+        auto const stepCount = glm::abs(lastVoxel - voxel);
+        int const maxSteps = stepCount.x + stepCount.y + stepCount.z;
+
+        visitor(voxel);
+        for (int i = 0; i < maxSteps && voxel != lastVoxel; i++)
+        {
+            int axis = 0;
+            if (tMax[1] < tMax[axis])
+            {
+                axis = 1;
+            }
+            if (tMax[2] < tMax[axis])
+            {
+                axis = 2;
+            }
+            voxel[axis] += step[axis];
+            tMax[axis] += tDelta[axis];
+            visitor(voxel);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void ReachabilityMap::PropagateDistances()
+    {
+        auto const resolution = _params.resolution;
+
+        // Breadth first from every reached voxel at once, each voxel takes the seed of whichever front arrives first
+        std::queue<glm::ivec3> queue{};
+        for (int z = 0; z < resolution; z++)
+        {
+            for (int y = 0; y < resolution; y++)
+            {
+                for (int x = 0; x < resolution; x++)
+                {
+                    if (_distance[VoxelIndex({x, y, z})] == 0)
+                    {
+                        queue.emplace(x, y, z);
+                    }
+                }
+            }
+        }
+
+        static constexpr glm::ivec3 neighbours[6]
+        {
+            {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+        };
+
+        while (queue.empty() == false)
+        {
+            auto const voxel = queue.front();
+            queue.pop();
+            auto const voxelIdx = VoxelIndex(voxel);
+
+            for (auto const & offset : neighbours)
+            {
+                auto const neighbour = voxel + offset;
+                if (glm::any(glm::lessThan(neighbour, glm::ivec3{0})) ||
+                    glm::any(glm::greaterThanEqual(neighbour, glm::ivec3{resolution})))
+                {
+                    continue;
+                }
+                auto const neighbourIdx = VoxelIndex(neighbour);
+                auto const seedIndex = _nearestSeed[voxelIdx];
+                if (_nearestSeed[neighbourIdx] >= 0)
+                {
+                    // Fronts of the same distance meet here, keep the seed that ends closer to the voxel. Without it
+                    // the 6 neighbour fronts pick the closest seed in manhattan distance instead of euclidean.
+                    if (_distance[neighbourIdx] == _distance[voxelIdx] + 1 && _distance[neighbourIdx] < 255)
+                    {
+                        auto const center = _origin + (glm::vec3{neighbour} + 0.5f) * _voxelSize;
+                        auto const currentOffset = _seedEndPoints[_nearestSeed[neighbourIdx]] - center;
+                        auto const candidateOffset = _seedEndPoints[seedIndex] - center;
+                        if (glm::dot(candidateOffset, candidateOffset) < glm::dot(currentOffset, currentOffset))
+                        {
+                            _nearestSeed[neighbourIdx] = seedIndex;
+                        }
+                    }
+                    continue;
+                }
+                _nearestSeed[neighbourIdx] = seedIndex;
+                _distance[neighbourIdx] = static_cast<uint8_t>(std::min(_distance[voxelIdx] + 1, 255));
+                queue.emplace(neighbour);
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Joint.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace Shared
+{
+
+    // Voxel map of the end points a chain can reach, built once per rig by sampling its configuration space.
+    // Queries are O(1): a target is looked up in its voxel, which knows the distance (in voxels) to the closest
+    // reached voxel and which sampled pose reached it. The solver uses it to reject or clamp targets that can never be
+    // reached before iterating, and to seed the solve from the sampled pose closest to the target.
+    class ReachabilityMap
+    {
+    public:
+
+        struct Params
+        {
+            int resolution = 32;            // Voxels along each axis of the cube around the reach sphere
+            int sampleCount = 100000;       // Configurations visited by the random walks
+            int walkLength = 64;            // Steps of a walk before it restarts from a uniformly sampled pose
+            float angleStep = 4.0f;         // Largest angle change of a walk step in degree
+            float lengthStep = 0.02f;       // Largest length change of a walk step relative to the reach
+            float margin = 2.0f;            // Voxels around the reached ones that still count as reachable
+            uint32_t seed = 0;
+        };
+
+        struct Query
+        {
+            bool isReachable = true;
+            glm::vec3 nearestReachable {};  // The target itself when reachable, otherwise a sampled end point
+            int seedIndex = -1;             // Sampled pose closest to the target, -1 if there is none
+            glm::vec3 seedEndPoint {};      // End point of that pose
+        };
+
+        // Samples the chain. Fixed DOFs keep their value, free DOFs are sampled inside their limits.
+        // A free length without an upper limit makes the reach unbounded, every target then counts as reachable.
+        void Build(Chain const & chain, Params const & params);
+
+        [[nodiscard]]
+        bool IsBuilt() const;
+
+        // True if the chain has the joint count, fixed DOFs and limits the map was built with
+        [[nodiscard]]
+        bool Matches(Chain const & chain) const;
+
+        [[nodiscard]]
+        Query Find(glm::vec3 const & target) const;
+
+        // Writes the sampled pose into the free DOFs of the chain. The chain must match the map.
+        void ApplySeed(int seedIndex, Chain & chain) const;
+
+        [[nodiscard]]
+        int OccupiedVoxelCount() const;
+
+        [[nodiscard]]
+        float VoxelSize() const;
+
+    private:
+
+        [[nodiscard]]
+        glm::ivec3 ToVoxel(glm::vec3 const & position) const;
+
+        [[nodiscard]]
+        int VoxelIndex(glm::ivec3 const & voxel) const;
+
+        // Keeps the sample as the seed of the voxel if its end point is closer to the voxel center
+        void Record(glm::ivec3 const & voxel, Chain const & pose, glm::vec3 const & endPoint);
+
+        // Visits every voxel on the segment (Amanatides and Woo traversal)
+        template<typename Visitor>
+        void TraverseVoxels(glm::vec3 const & start, glm::vec3 const & end, Visitor const & visitor) const;
+
+        // Spreads the closest seed and its voxel distance from the reached voxels to the whole grid
+        void PropagateDistances();
+
+        Params _params{};
+        Chain _rig{};
+        bool _isBuilt = false;
+        bool _isUnbounded = false;
+
+        glm::vec3 _origin {};               // Corner of the grid
+        float _voxelSize {};
+        int _occupiedCount {};
+
+        std::vector<int> _nearestSeed{};    // Per voxel
+        std::vector<uint8_t> _distance{};   // Per voxel, in voxels and saturated at 255
+
+        // Per seed
+        std::vector<glm::vec3> _seedValues{};   // (length, x angle, y angle) of every joint
+        std::vector<glm::vec3> _seedEndPoints{};
+
+    };
+
+}
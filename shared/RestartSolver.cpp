@@ -0,0 +1,221 @@
+#include "RestartSolver.hpp"
+
+#include "BedrockAssert.hpp"
+#include "JobSystem.hpp"
+#include "TaskDispatch.hpp"
+
+#include <random>
+
+namespace Shared
+{
+
+    //-------------------------------------------------------------------------------------------------
+
+    RestartSolver::RestartSolver(
+        InverseKinematic::Params const & solverParams,
+        Params const & params,
+        int const workerCount
+    )
+        : _solverParams(solverParams)
+    {
+        SetParams(params);
+        SetWorkerCount(workerCount);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Result RestartSolver::Solve(Chain & chain, glm::vec3 const & target)
+    {
+        return SolveImpl(chain, target);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Result RestartSolver::Solve(Chain & chain, InverseKinematic::PoseTarget const & target)
+    {
+        return SolveImpl(chain, target);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<typename Target>
+    InverseKinematic::Result RestartSolver::SolveImpl(Chain & chain, Target const & target)
+    {
+        auto const restartCount = _params.restartCount;
+        _starts.resize(restartCount);
+        _results.assign(restartCount, InverseKinematic::Result{});
+
+        // Every restart shares this flag, the first one that converges raises it. A cancel flag of the caller is
+        // forwarded into it between restarts, so raising that one stops the running restarts too.
+        auto const * callerCancel = _solverParams.cancel;
+        auto const isCallerCancelled = [callerCancel]()->bool
+        {
+            return callerCancel != nullptr && callerCancel->load(std::memory_order_relaxed) == true;
+        };
+        std::atomic<bool> cancel = isCallerCancelled();
+        std::vector<uint8_t> isCancelled(restartCount, 0);
+
+        auto solverParams = _solverParams;
+        solverParams.cancel = &cancel;
+        InverseKinematic const solver(solverParams);
+
+        for (int i = 0; i < restartCount; i++)
+        {
+            PerturbStart(chain, i, _starts[i]);
+        }
+
+        // Without a job system the restarts run one after the other and still stop at the first converged one
+        int const taskCount = MFA::JobSystem::Instance != nullptr
+            ? std::max(std::min(_workerCount, restartCount), 1)
+            : 1;
+
+        auto const task = [&, taskCount](int const taskIdx)->void
+        {
+            // Restarts are interleaved between the tasks so the unperturbed start always runs first
+            for (int i = taskIdx; i < restartCount; i += taskCount)
+            {
+                if (isCallerCancelled() == true)
+                {
+                    cancel.store(true, std::memory_order_relaxed);
+                }
+                // The unperturbed start always runs, a cancelled solve still reports its start pose
+                if (i > 0 && cancel.load(std::memory_order_relaxed) == true)
+                {
+                    isCancelled[i] = 1;
+                    _results[i].error = std::numeric_limits<float>::infinity();
+                    continue;
+                }
+
+                _results[i] = solver.Solve(_starts[i], target, _workspaces[taskIdx]);
+                if (isCallerCancelled() == true)
+                {
+                    cancel.store(true, std::memory_order_relaxed);
+                }
+                if (_results[i].converged == true)
+                {
+                    cancel.store(true, std::memory_order_relaxed);
+                }
+                else if (cancel.load(std::memory_order_relaxed) == true)
+                {
+                    isCancelled[i] = 1;
+                }
+            }
+        };
+        DispatchTasks(taskCount, task, true).get();
+
+        _statistics = {};
+        for (int i = 0; i < restartCount; i++)
+        {
+            auto const & result = _results[i];
+            _statistics.convergedRestarts += result.converged == true ? 1 : 0;
+            _statistics.cancelledRestarts += isCancelled[i];
+
+            // Restart 0 is kept even without iterations, it is the result of a solve cancelled by the caller
+            if (i > 0 && isCancelled[i] == 1 && result.iterations == 0)
+            {
+                continue;
+            }
+            if (_statistics.bestRestart < 0)
+            {
+                _statistics.bestRestart = i;
+                continue;
+            }
+            auto const & best = _results[_statistics.bestRestart];
+            if (result.converged != best.converged
+                ? result.converged == true
+                : result.error < best.error)
+            {
+                _statistics.bestRestart = i;
+            }
+        }
+
+        MFA_ASSERT(_statistics.bestRestart >= 0);
+        chain = _starts[_statistics.bestRestart];
+        return _results[_statistics.bestRestart];
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void RestartSolver::PerturbStart(Chain const & chain, int const restartIdx, Chain & outStart) const
+    {
+        outStart = chain;
+        if (restartIdx == 0)
+        {
+            return;
+        }
+
+        std::minstd_rand random(_params.seed * 7919u + static_cast<uint32_t>(restartIdx));
+        std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+
+        for (auto & joint : outStart)
+        {
+            if (joint.isLengthFixed == false)
+            {
+                joint.length *= 1.0f + offset(random) * _params.lengthSpread;
+            }
+            if (joint.isX_AngleFixed == false)
+            {
+                joint.angle.x += offset(random) * _params.angleSpread;
+            }
+            if (joint.isY_AngleFixed == false)
+            {
+                joint.angle.y += offset(random) * _params.angleSpread;
+            }
+            ClampToLimits(joint);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    RestartSolver::Statistics const & RestartSolver::GetLastStatistics() const
+    {
+        return _statistics;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void RestartSolver::SetWorkerCount(int workerCount)
+    {
+        if (workerCount <= 0)
+        {
+            workerCount = MFA::JobSystem::Instance != nullptr
+                ? MFA::JobSystem::Instance->NumberOfAvailableThreads()
+                : 1;
+        }
+        _workerCount = std::max(workerCount, 1);
+        _workspaces.resize(_workerCount);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int RestartSolver::GetWorkerCount() const
+    {
+        return _workerCount;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void RestartSolver::SetParams(Params const & params)
+    {
+        MFA_ASSERT(params.restartCount > 0);
+        _params = params;
+        _params.restartCount = std::max(_params.restartCount, 1);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    RestartSolver::Params const & RestartSolver::GetParams() const
+    {
+        return _params;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void RestartSolver::SetSolverParams(InverseKinematic::Params const & solverParams)
+    {
+        _solverParams = solverParams;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "InverseKinematic.hpp"
+
+namespace Shared
+{
+
+    // Runs the same solve from several perturbed start poses at once on the MFA::JobSystem workers. The first restart
+    // that converges cancels the others, so the latency is bound by the fastest restart instead of the sum of them.
+    // Meant for targets close to the workspace boundary where a single start tends to stall in a local minimum.
+    // InverseKinematic::Params::cancel of the solver params cancels the whole solve. It is checked between
+    // restarts, the unperturbed start is always solved so there is a result to return.
+    // Must not be called from a JobSystem worker since it waits for the restarts it assigns.
+    class RestartSolver
+    {
+    public:
+
+        struct Params
+        {
+            int restartCount = 8;           // Including the unperturbed start
+            float angleSpread = 45.0f;      // Largest offset of a free angle in degree
+            float lengthSpread = 0.25f;     // Largest offset of a free length relative to the length
+            uint32_t seed = 0;              // Same seed and input give the same starts
+        };
+
+        struct Statistics
+        {
+            int bestRestart = -1;           // 0 is the unperturbed start
+            int convergedRestarts {};
+            int cancelledRestarts {};       // Stopped early or never started because another restart converged
+        };
+
+        // workerCount <= 0 means one worker per job system thread
+        explicit RestartSolver(
+            InverseKinematic::Params const & solverParams,
+            Params const & params,
+            int workerCount = 0
+        );
+
+        // Solves every restart and writes the best pose into the chain. A converged pose beats an unconverged one,
+        // then the smaller error wins.
+        InverseKinematic::Result Solve(Chain & chain, glm::vec3 const & target);
+
+        InverseKinematic::Result Solve(Chain & chain, InverseKinematic::PoseTarget const & target);
+
+        [[nodiscard]]
+        Statistics const & GetLastStatistics() const;
+
+        void SetWorkerCount(int workerCount);
+
+        [[nodiscard]]
+        int GetWorkerCount() const;
+
+        void SetParams(Params const & params);
+
+        [[nodiscard]]
+        Params const & GetParams() const;
+
+        void SetSolverParams(InverseKinematic::Params const & solverParams);
+
+    private:
+
+        template<typename Target>
+        InverseKinematic::Result SolveImpl(Chain & chain, Target const & target);
+
+        // Writes a perturbed copy of the chain for the restart. Fixed DOFs are kept and limits are respected.
+        void PerturbStart(Chain const & chain, int restartIdx, Chain & outStart) const;
+
+        InverseKinematic::Params _solverParams{};
+        Params _params{};
+        int _workerCount {};
+
+        // Per restart buffers so the tasks share nothing but the cancel flag
+        std::vector<Chain> _starts{};
+        std::vector<InverseKinematic::Result> _results{};
+        std::vector<InverseKinematic::Workspace> _workspaces{};
+
+        Statistics _statistics{};
+
+    };
+
+}
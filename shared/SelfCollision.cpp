@@ -0,0 +1,213 @@
+#include "SelfCollision.hpp"
+
+#include "KinematicChain.hpp"
+#include "ObstacleBVH.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+namespace Shared
+{
+
+    //-------------------------------------------------------------------------------------------------
+
+    void SelfCollision::FindContacts(
+        KinematicChain const & chain,
+        float const boneRadius,
+        float const clearance,
+        std::vector<Contact> & outContacts
+    )
+    {
+        auto const start = std::chrono::steady_clock::now();
+
+        auto const jointCount = chain.JointCount();
+        if (static_cast<int>(_boneCells.size()) != jointCount || _boneRadius != boneRadius || _clearance != clearance)
+        {
+            Rebuild(chain, boneRadius, clearance);
+        }
+
+        _statistics = {};
+        for (int bone = 0; bone < jointCount; bone++)
+        {
+            _starts[bone] = chain.Pivot(bone);
+            _ends[bone] = chain.WorldMatrix(bone)[3];
+            if (UpdateBone(bone, _starts[bone], _ends[bone]) == true)
+            {
+                _statistics.movedBones++;
+            }
+        }
+
+        std::fill(_visitStamp.begin(), _visitStamp.end(), -1);
+        float const contactDistance = 2.0f * boneRadius + clearance;
+
+        for (int boneA = 0; boneA < jointCount; boneA++)
+        {
+            ForEachBucket(_boneCells[boneA], [&](std::vector<int> & bucket)->void
+            {
+                for (auto const boneB : bucket)
+                {
+                    // Neighbours share a joint and always touch, every pair is tested once from its lower bone
+                    if (boneB <= boneA + 1 || _visitStamp[boneB] == boneA)
+                    {
+                        continue;
+                    }
+                    _visitStamp[boneB] = boneA;
+                    _statistics.candidatePairs++;
+
+                    auto const st = ClosestPointsOfSegments(_starts[boneA], _ends[boneA], _starts[boneB], _ends[boneB]);
+                    auto const onA = _starts[boneA] + (_ends[boneA] - _starts[boneA]) * st.x;
+                    auto const onB = _starts[boneB] + (_ends[boneB] - _starts[boneB]) * st.y;
+
+                    auto const offset = onB - onA;
+                    float const distance = glm::length(offset);
+                    float const depth = contactDistance - distance;
+                    if (depth <= 0.0f)
+                    {
+                        continue;
+                    }
+
+                    Contact contact{};
+                    contact.boneA = boneA;
+                    contact.boneB = boneB;
+                    contact.tA = st.x;
+                    contact.tB = st.y;
+                    contact.depth = depth;
+                    if (distance > glm::epsilon<float>())
+                    {
+                        contact.normal = offset / distance;
+                    }
+                    else
+                    {
+                        // The bones cross, separate them along the normal of both
+                        auto const side = glm::cross(_ends[boneA] - _starts[boneA], _ends[boneB] - _starts[boneB]);
+                        contact.normal = glm::length(side) > glm::epsilon<float>()
+                            ? glm::normalize(side)
+                            : glm::vec3{1.0f, 0.0f, 0.0f};
+                    }
+                    outContacts.emplace_back(contact);
+                    _statistics.contacts++;
+                }
+            });
+        }
+
+        auto const end = std::chrono::steady_clock::now();
+        _statistics.elapsedUs = std::chrono::duration<float, std::micro>(end - start).count();
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void SelfCollision::Reset()
+    {
+        _buckets.clear();
+        _boneCells.clear();
+        _starts.clear();
+        _ends.clear();
+        _visitStamp.clear();
+        _boneRadius = -1.0f;
+        _clearance = -1.0f;
+        _statistics = {};
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    SelfCollision::Statistics const & SelfCollision::GetStatistics() const
+    {
+        return _statistics;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void SelfCollision::Rebuild(KinematicChain const & chain, float const boneRadius, float const clearance)
+    {
+        auto const jointCount = chain.JointCount();
+        _boneRadius = boneRadius;
+        _clearance = clearance;
+        _inflation = boneRadius + clearance * 0.5f;
+
+        // Cells of two bone lengths keep a bone inside one or two cells per axis. Smaller cells put every bone into
+        // more buckets and measured slower. Lengths may change while solving, the cell size only affects the cost of
+        // the broad phase and is kept until the next rebuild.
+        float totalLength = 0.0f;
+        for (int bone = 0; bone < jointCount; bone++)
+        {
+            totalLength += glm::length(glm::vec3(chain.WorldMatrix(bone)[3]) - chain.Pivot(bone));
+        }
+        float const averageLength = jointCount > 0 ? totalLength / static_cast<float>(jointCount) : 0.0f;
+        _cellSize = std::max({2.0f * averageLength, 2.0f * _inflation, 1e-3f});
+
+        // Eight buckets per bone keep the chance of unrelated cells sharing a bucket low
+        size_t bucketCount = 64;
+        while (bucketCount < 8 * static_cast<size_t>(jointCount))
+        {
+            bucketCount *= 2;
+        }
+        _buckets.assign(bucketCount, {});
+        _boneCells.assign(jointCount, BoneCells{});
+        _starts.assign(jointCount, {});
+        _ends.assign(jointCount, {});
+        _visitStamp.assign(jointCount, -1);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool SelfCollision::UpdateBone(int const bone, glm::vec3 const & start, glm::vec3 const & end)
+    {
+        BoneCells cells{};
+        cells.min = glm::ivec3(glm::floor((glm::min(start, end) - _inflation) / _cellSize));
+        cells.max = glm::ivec3(glm::floor((glm::max(start, end) + _inflation) / _cellSize));
+
+        auto & current = _boneCells[bone];
+        if (cells.min == current.min && cells.max == current.max)
+        {
+            return false;
+        }
+
+        ForEachBucket(current, [bone](std::vector<int> & bucket)->void
+        {
+            auto const itr = std::find(bucket.begin(), bucket.end(), bone);
+            if (itr != bucket.end())
+            {
+                *itr = bucket.back();
+                bucket.pop_back();
+            }
+        });
+        ForEachBucket(cells, [bone](std::vector<int> & bucket)->void
+        {
+            bucket.emplace_back(bone);
+        });
+        current = cells;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    size_t SelfCollision::BucketIndex(glm::ivec3 const & cell) const
+    {
+        auto const x = static_cast<uint32_t>(cell.x) * 73856093u;
+        auto const y = static_cast<uint32_t>(cell.y) * 19349663u;
+        auto const z = static_cast<uint32_t>(cell.z) * 83492791u;
+        return static_cast<size_t>(x ^ y ^ z) & (_buckets.size() - 1);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<typename Visitor>
+    void SelfCollision::ForEachBucket(BoneCells const & cells, Visitor const & visitor)
+    {
+        for (int x = cells.min.x; x <= cells.max.x; x++)
+        {
+            for (int y = cells.min.y; y <= cells.max.y; y++)
+            {
+                for (int z = cells.min.z; z <= cells.max.z; z++)
+                {
+                    visitor(_buckets[BucketIndex(glm::ivec3{x, y, z})]);
+                }
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
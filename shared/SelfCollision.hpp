@@ -0,0 +1,88 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace Shared
+{
+
+    class KinematicChain;
+
+    // Finds bones of a chain that come closer to each other than a clearance. Every bone is a capsule whose bounds are
+    // stored in a uniform spatial hash, only bones that share a cell are tested, so the cost follows the number of
+    // nearby bones instead of all n^2 pairs. The hash is updated incrementally: a bone is only moved to other buckets
+    // when the range of cells its bounds cover changes.
+    // Bones that share a joint are never reported.
+    class SelfCollision
+    {
+    public:
+
+        struct Contact
+        {
+            int boneA = -1;                 // boneA < boneB
+            int boneB = -1;
+            float tA {};                    // Closest points along the bones, 0 at the pivot and 1 at the end
+            float tB {};
+            glm::vec3 normal {};            // Unit direction from the point on boneA to the point on boneB
+            float depth {};                 // How far the bones have to separate to reach the clearance
+        };
+
+        struct Statistics
+        {
+            int candidatePairs {};          // Pairs that shared a hash bucket and went to the narrow phase
+            int contacts {};
+            int movedBones {};              // Bones whose cell range changed in the last update
+            float elapsedUs {};             // Update and query of the last FindContacts
+        };
+
+        // Updates the hash with the current bone positions and appends a contact for every pair of bones closer than
+        // clearance. Changing the joint count, the radius or the clearance rebuilds the hash from scratch.
+        void FindContacts(
+            KinematicChain const & chain,
+            float boneRadius,
+            float clearance,
+            std::vector<Contact> & outContacts
+        );
+
+        // Drops the hash, the next FindContacts rebuilds it
+        void Reset();
+
+        [[nodiscard]]
+        Statistics const & GetStatistics() const;
+
+    private:
+
+        struct BoneCells
+        {
+            glm::ivec3 min {};
+            glm::ivec3 max {-1};            // Empty range before the first insertion
+        };
+
+        void Rebuild(KinematicChain const & chain, float boneRadius, float clearance);
+
+        // Moves the bone to the buckets of its new cell range. Returns false if the range did not change.
+        bool UpdateBone(int bone, glm::vec3 const & start, glm::vec3 const & end);
+
+        [[nodiscard]]
+        size_t BucketIndex(glm::ivec3 const & cell) const;
+
+        template<typename Visitor>
+        void ForEachBucket(BoneCells const & cells, Visitor const & visitor);
+
+        float _cellSize {};
+        float _inflation {};                // Bone radius plus half of the clearance
+        float _boneRadius = -1.0f;
+        float _clearance = -1.0f;
+
+        std::vector<std::vector<int>> _buckets{};
+        std::vector<BoneCells> _boneCells{};
+        std::vector<glm::vec3> _starts{};   // Bone segments of the last update
+        std::vector<glm::vec3> _ends{};
+        std::vector<int> _visitStamp{};     // Last bone that tested this bone, removes duplicate pairs
+
+        Statistics _statistics{};
+
+    };
+
+}
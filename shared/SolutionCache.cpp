@@ -0,0 +1,117 @@
+#include "SolutionCache.hpp"
+
+namespace Shared
+{
+
+    //-------------------------------------------------------------------------------------------------
+
+    float SolutionCache::Statistics::HitRate() const
+    {
+        auto const total = hitCount + missCount;
+        return total > 0 ? static_cast<float>(hitCount) / static_cast<float>(total) : 0.0f;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Result SolutionCache::Solve(
+        InverseKinematic const & solver,
+        RigId const rigId,
+        Chain & chain,
+        glm::vec3 const & target
+    )
+    {
+        auto & entry = _entries[rigId];
+
+        bool const isHit = entry.rig.empty() == false && IsSameRig(entry.rig, chain) == true;
+        if (isHit == true)
+        {
+            _statistics.hitCount++;
+            // A chain that is still the pose returned last time carries the progress of that solve even if it did
+            // not converge, so it is kept. Any other pose, for example a rest pose handed in every frame, starts
+            // from the last converged pose instead.
+            if (entry.convergedPose.empty() == false && chain != entry.rig)
+            {
+                chain = entry.convergedPose;
+            }
+            // The jacobian belongs to the pose returned last time
+            entry.workspace.isJacobianReusable &= chain == entry.rig;
+            entry.workspace.warmStart = true;
+        }
+        else
+        {
+            _statistics.missCount++;
+            entry.convergedPose.clear();
+        }
+
+        auto const result = solver.Solve(chain, target, entry.workspace);
+
+        entry.rig = chain;
+        if (result.converged == true)
+        {
+            entry.convergedPose = chain;
+        }
+        return result;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void SolutionCache::Invalidate(RigId const rigId)
+    {
+        _entries.erase(rigId);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void SolutionCache::Clear()
+    {
+        _entries.clear();
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    SolutionCache::Statistics const & SolutionCache::GetStatistics() const
+    {
+        return _statistics;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void SolutionCache::ResetStatistics()
+    {
+        _statistics = {};
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool SolutionCache::IsSameRig(Chain const & lhs, Chain const & rhs)
+    {
+        if (lhs.size() != rhs.size())
+        {
+            return false;
+        }
+        for (size_t jointIdx = 0; jointIdx < lhs.size(); ++jointIdx)
+        {
+            auto const & l = lhs[jointIdx];
+            auto const & r = rhs[jointIdx];
+            if (ActiveDOF_Mask(l) != ActiveDOF_Mask(r))
+            {
+                return false;
+            }
+            if ((l.isLengthFixed == true && l.length != r.length) ||
+                (l.isX_AngleFixed == true && l.angle.x != r.angle.x) ||
+                (l.isY_AngleFixed == true && l.angle.y != r.angle.y))
+            {
+                return false;
+            }
+            // The converged pose would bring back the old limits
+            if (l.minLimit != r.minLimit || l.maxLimit != r.maxLimit)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
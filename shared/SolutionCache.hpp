@@ -0,0 +1,67 @@
+#pragma once
+
+#include "InverseKinematic.hpp"
+
+#include <unordered_map>
+
+namespace Shared
+{
+
+    // Keeps the solver state of every rig between solves so that a target that moves a little per frame is solved
+    // from the last converged pose, the last jacobian (and joint space factorization) and the last damping.
+    // Rigs routed to a FixedChainSolver carry over the damping only, their jacobian is rebuilt on every solve. The
+    // two bone, FABRIK and CCD solvers keep no state, for them only the pose is carried over.
+    // Not thread safe, use one cache per thread or per group of rigs.
+    class SolutionCache
+    {
+    public:
+
+        using RigId = uint64_t;
+
+        struct Statistics
+        {
+            uint64_t hitCount {};           // Solves seeded from a previous solve of the same rig
+            uint64_t missCount {};          // Unknown rig or the rig definition changed
+
+            [[nodiscard]]
+            float HitRate() const;
+        };
+
+        // Solves the chain of the rig. On a hit a chain that is not the pose returned by the last solve of the rig
+        // is replaced by the last converged pose, a chain that is continues from where that solve stopped.
+        // A rig counts as changed when its joint count, fixed flags, fixed values or limits differ from the cached one.
+        // Callers that edit free DOFs on purpose call Invalidate so the edit is not replaced.
+        InverseKinematic::Result Solve(
+            InverseKinematic const & solver,
+            RigId rigId,
+            Chain & chain,
+            glm::vec3 const & target
+        );
+
+        void Invalidate(RigId rigId);
+
+        void Clear();
+
+        [[nodiscard]]
+        Statistics const & GetStatistics() const;
+
+        void ResetStatistics();
+
+    private:
+
+        struct Entry
+        {
+            Chain rig{};                    // Chain of the last solve, used to detect rig changes
+            Chain convergedPose{};
+            InverseKinematic::Workspace workspace{};
+        };
+
+        [[nodiscard]]
+        static bool IsSameRig(Chain const & lhs, Chain const & rhs);
+
+        std::unordered_map<RigId, Entry> _entries{};
+        Statistics _statistics{};
+
+    };
+
+}
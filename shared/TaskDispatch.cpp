@@ -0,0 +1,81 @@
+#include "TaskDispatch.hpp"
+
+#include "BedrockAssert.hpp"
+#include "JobSystem.hpp"
+
+namespace Shared
+{
+
+    //-------------------------------------------------------------------------------------------------
+
+    std::future<void> DispatchTasks(
+        int const taskCount,
+        std::function<void(int taskIdx)> task,
+        bool const callerRunsFirstTask
+    )
+    {
+        MFA_ASSERT(taskCount > 0);
+
+        struct Completion
+        {
+            std::function<void(int taskIdx)> task{};
+            std::promise<void> promise{};
+            std::atomic<int> remainingTasks {};
+            std::exception_ptr exception{};
+            std::atomic<bool> hasException = false;
+        };
+        auto completion = std::make_shared<Completion>();
+        completion->task = std::move(task);
+        completion->remainingTasks = taskCount;
+        auto future = completion->promise.get_future();
+
+        auto const run = [completion](int const taskIdx)->void
+        {
+            try
+            {
+                completion->task(taskIdx);
+            }
+            catch (...)
+            {
+                if (completion->hasException.exchange(true) == false)
+                {
+                    completion->exception = std::current_exception();
+                }
+            }
+
+            // Last task to finish signals the whole group
+            if (completion->remainingTasks.fetch_sub(1) == 1)
+            {
+                if (completion->hasException == true)
+                {
+                    completion->promise.set_exception(completion->exception);
+                }
+                else
+                {
+                    completion->promise.set_value();
+                }
+            }
+        };
+
+        bool const hasWorkers = MFA::JobSystem::Instance != nullptr && taskCount > 1;
+        int const callerTaskCount = hasWorkers == false ? taskCount : (callerRunsFirstTask == true ? 1 : 0);
+
+        for (int taskIdx = callerTaskCount; taskIdx < taskCount; taskIdx++)
+        {
+            // The group has its own completion handle, the per task future is not needed
+            (void)MFA::JobSystem::Instance->AssignTask(std::function<void()>([run, taskIdx]()->void
+            {
+                run(taskIdx);
+            }));
+        }
+        for (int taskIdx = 0; taskIdx < callerTaskCount; taskIdx++)
+        {
+            run(taskIdx);
+        }
+
+        return future;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
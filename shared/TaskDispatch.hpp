@@ -0,0 +1,18 @@
+#pragma once
+
+#include <functional>
+#include <future>
+
+namespace Shared
+{
+
+    // Runs task(0) ... task(taskCount - 1) on the MFA::JobSystem workers and returns a single future that is ready
+    // once all of them have finished. The first exception thrown by a task is rethrown by the future, the other
+    // tasks still run to the end. With callerRunsFirstTask the calling thread runs task 0 before returning instead of
+    // idling, the caller then has to wait for the future and must not be a JobSystem worker. Without a job system,
+    // or with a single task, every task runs on the calling thread one after the other.
+    // The task and everything it refers to must stay alive until the future is ready.
+    [[nodiscard]]
+    std::future<void> DispatchTasks(int taskCount, std::function<void(int taskIdx)> task, bool callerRunsFirstTask);
+
+}
@@ -0,0 +1,222 @@
+#include "TrajectorySolver.hpp"
+
+#include "BedrockAssert.hpp"
+#include "JobSystem.hpp"
+#include "TaskDispatch.hpp"
+
+#include <chrono>
+
+namespace Shared
+{
+
+    //-------------------------------------------------------------------------------------------------
+
+    TrajectorySolver::TrajectorySolver(
+        InverseKinematic::Params const & solverParams,
+        Params const & params,
+        int const workerCount
+    )
+        : _solver(solverParams)
+    {
+        SetParams(params);
+        SetWorkerCount(workerCount);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TrajectorySolver::Solve(
+        Chain const & initialChain,
+        std::vector<float> const & times,
+        std::vector<glm::vec3> const & targets,
+        Chain & outPoses,
+        std::vector<InverseKinematic::Result> & outResults
+    )
+    {
+        SolveImpl(initialChain, times, targets, outPoses, outResults);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TrajectorySolver::Solve(
+        Chain const & initialChain,
+        std::vector<float> const & times,
+        std::vector<InverseKinematic::PoseTarget> const & targets,
+        Chain & outPoses,
+        std::vector<InverseKinematic::Result> & outResults
+    )
+    {
+        SolveImpl(initialChain, times, targets, outPoses, outResults);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<typename Target>
+    void TrajectorySolver::SolveImpl(
+        Chain const & initialChain,
+        std::vector<float> const & times,
+        std::vector<Target> const & targets,
+        Chain & outPoses,
+        std::vector<InverseKinematic::Result> & outResults
+    )
+    {
+        MFA_ASSERT(times.empty() == true || times.size() == targets.size());
+
+        auto const start = std::chrono::high_resolution_clock::now();
+
+        auto const sampleCount = static_cast<int>(targets.size());
+        auto const jointCount = initialChain.size();
+        outPoses.resize(static_cast<size_t>(sampleCount) * jointCount);
+        outResults.resize(sampleCount);
+
+        SplitSegments(times, sampleCount);
+        auto const segmentCount = static_cast<int>(_segments.size());
+
+        // Segments are handed out in order, the next free one goes to the first task that asks for it
+        std::atomic<int> nextSegment = 0;
+        std::atomic<int> warmUpSolves = 0;
+
+        int const taskCount = MFA::JobSystem::Instance != nullptr
+            ? std::max(std::min(_workerCount, segmentCount), 1)
+            : 1;
+
+        auto const task = [&](int const taskIdx)->void
+        {
+            auto & chain = _chains[taskIdx];
+            auto & workspace = _workspaces[taskIdx];
+            for (
+                int segmentIdx = nextSegment.fetch_add(1);
+                segmentIdx < segmentCount;
+                segmentIdx = nextSegment.fetch_add(1)
+            )
+            {
+                auto const & segment = _segments[segmentIdx];
+
+                // The first solve of a segment has nothing to warm start from
+                chain = initialChain;
+                workspace.warmStart = false;
+                for (int i = segment.warmUpBegin; i < segment.begin; i++)
+                {
+                    (void)_solver.Solve(chain, targets[i], workspace);
+                    workspace.warmStart = true;
+                }
+                warmUpSolves.fetch_add(segment.begin - segment.warmUpBegin, std::memory_order_relaxed);
+
+                for (int i = segment.begin; i < segment.end; i++)
+                {
+                    outResults[i] = _solver.Solve(chain, targets[i], workspace);
+                    workspace.warmStart = true;
+                    auto const poseBegin = outPoses.begin() + static_cast<ptrdiff_t>(i * jointCount);
+                    std::copy(chain.begin(), chain.end(), poseBegin);
+                }
+            }
+        };
+        DispatchTasks(taskCount, task, true).get();
+
+        auto const end = std::chrono::high_resolution_clock::now();
+
+        _statistics = {};
+        _statistics.segmentCount = segmentCount;
+        _statistics.warmUpSolves = warmUpSolves;
+        for (auto const & result : outResults)
+        {
+            _statistics.convergedSamples += result.converged == true ? 1 : 0;
+        }
+        _statistics.seconds = std::chrono::duration<double>(end - start).count();
+        _statistics.samplesPerSecond = _statistics.seconds > 0.0
+            ? static_cast<double>(sampleCount) / _statistics.seconds
+            : 0.0;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TrajectorySolver::SplitSegments(std::vector<float> const & times, int const sampleCount)
+    {
+        _segments.clear();
+
+        int runBegin = 0;
+        while (runBegin < sampleCount)
+        {
+            // A continuous run ends at the first time step above the gap
+            int runEnd = runBegin + 1;
+            if (_params.maxTimeGap > 0.0f && times.empty() == false)
+            {
+                while (runEnd < sampleCount && times[runEnd] - times[runEnd - 1] <= _params.maxTimeGap)
+                {
+                    runEnd++;
+                }
+            }
+            else
+            {
+                runEnd = sampleCount;
+            }
+
+            int const partLength = _params.segmentLength > 0 ? _params.segmentLength : runEnd - runBegin;
+            for (int begin = runBegin; begin < runEnd; begin += partLength)
+            {
+                Segment segment{};
+                segment.begin = begin;
+                segment.end = std::min(begin + partLength, runEnd);
+                segment.warmUpBegin = std::max(begin - _params.warmUpSamples, runBegin);
+                _segments.emplace_back(segment);
+            }
+
+            runBegin = runEnd;
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    TrajectorySolver::Statistics const & TrajectorySolver::GetLastStatistics() const
+    {
+        return _statistics;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TrajectorySolver::SetWorkerCount(int workerCount)
+    {
+        if (workerCount <= 0)
+        {
+            workerCount = MFA::JobSystem::Instance != nullptr
+                ? MFA::JobSystem::Instance->NumberOfAvailableThreads()
+                : 1;
+        }
+        _workerCount = std::max(workerCount, 1);
+        _chains.resize(_workerCount);
+        _workspaces.resize(_workerCount);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int TrajectorySolver::GetWorkerCount() const
+    {
+        return _workerCount;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TrajectorySolver::SetParams(Params const & params)
+    {
+        MFA_ASSERT(params.segmentLength >= 0 && params.warmUpSamples >= 0);
+        _params = params;
+        _params.segmentLength = std::max(_params.segmentLength, 0);
+        _params.warmUpSamples = std::max(_params.warmUpSamples, 0);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    TrajectorySolver::Params const & TrajectorySolver::GetParams() const
+    {
+        return _params;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TrajectorySolver::SetSolverParams(InverseKinematic::Params const & solverParams)
+    {
+        _solver.SetParams(solverParams);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
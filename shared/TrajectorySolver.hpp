@@ -0,0 +1,114 @@
+#pragma once
+
+#include "InverseKinematic.hpp"
+
+namespace Shared
+{
+
+    // Solves a whole sequence of targets, for example an offline motion, as one batch. Every sample starts from the
+    // pose, jacobian and damping of the previous sample so a smooth trajectory needs only a few iterations per sample.
+    // The sequence is cut into segments that are solved on the MFA::JobSystem workers. A worker takes the next
+    // segment as soon as it finishes one, so long and short segments are balanced without a fixed split.
+    // Must not be called from a JobSystem worker since it waits for the segments it assigns.
+    class TrajectorySolver
+    {
+    public:
+
+        struct Params
+        {
+            // A time step larger than this starts an independent segment from the initial chain, for example at the
+            // cut between two clips. 0 means the whole sequence is continuous.
+            float maxTimeGap = 0.0f;
+            // Continuous runs can also be split into parts of this many samples so one long run is solved in
+            // parallel, 0 keeps every run in one piece. Each part after the first replays warmUpSamples targets of
+            // the part before it from the initial chain, so its first sample is warm started like the others. A
+            // redundant chain still settles in a different (equally valid) pose than the sequential solve, which
+            // shows as a jump at the border, so only split runs whose poses do not have to be continuous.
+            int segmentLength = 0;
+            int warmUpSamples = 16;
+        };
+
+        struct Statistics
+        {
+            int segmentCount {};            // Parts the sequence was split into
+            int convergedSamples {};
+            int warmUpSolves {};            // Extra solves spent on replaying the start of a part
+            double seconds {};
+            double samplesPerSecond {};
+        };
+
+        // workerCount <= 0 means one worker per job system thread
+        explicit TrajectorySolver(
+            InverseKinematic::Params const & solverParams,
+            Params const & params,
+            int workerCount = 0
+        );
+
+        // Solves targets[i] for every sample. times holds the timestamp of every sample and may be empty when the
+        // sequence has no cuts. The joints of sample i are written to outPoses[i * jointCount, (i + 1) * jointCount)
+        // and its result to outResults[i], both are resized to fit.
+        void Solve(
+            Chain const & initialChain,
+            std::vector<float> const & times,
+            std::vector<glm::vec3> const & targets,
+            Chain & outPoses,
+            std::vector<InverseKinematic::Result> & outResults
+        );
+
+        void Solve(
+            Chain const & initialChain,
+            std::vector<float> const & times,
+            std::vector<InverseKinematic::PoseTarget> const & targets,
+            Chain & outPoses,
+            std::vector<InverseKinematic::Result> & outResults
+        );
+
+        [[nodiscard]]
+        Statistics const & GetLastStatistics() const;
+
+        void SetWorkerCount(int workerCount);
+
+        [[nodiscard]]
+        int GetWorkerCount() const;
+
+        void SetParams(Params const & params);
+
+        [[nodiscard]]
+        Params const & GetParams() const;
+
+        void SetSolverParams(InverseKinematic::Params const & solverParams);
+
+    private:
+
+        struct Segment
+        {
+            int warmUpBegin {};             // First replayed sample, equal to begin when nothing is replayed
+            int begin {};
+            int end {};
+        };
+
+        template<typename Target>
+        void SolveImpl(
+            Chain const & initialChain,
+            std::vector<float> const & times,
+            std::vector<Target> const & targets,
+            Chain & outPoses,
+            std::vector<InverseKinematic::Result> & outResults
+        );
+
+        void SplitSegments(std::vector<float> const & times, int sampleCount);
+
+        InverseKinematic _solver;
+        Params _params{};
+        int _workerCount {};
+
+        std::vector<Segment> _segments{};
+        // Per task buffers so the tasks share nothing but the segment counter and the output
+        std::vector<Chain> _chains{};
+        std::vector<InverseKinematic::Workspace> _workspaces{};
+
+        Statistics _statistics{};
+
+    };
+
+}
@@ -0,0 +1,331 @@
+#include "TreeSolver.hpp"
+
+#include "ForwardKinematic.hpp"
+
+#include "BedrockAssert.hpp"
+#include "BedrockMath.hpp"
+
+namespace Shared
+{
+
+    using namespace MFA;
+
+    //-------------------------------------------------------------------------------------------------
+
+    TreeSolver::TreeSolver(InverseKinematic::Params const & params)
+        : _params(params)
+        , _root(ForwardKinematic::RootMatrix())
+    {
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TreeSolver::SetTopology(std::vector<int> parents)
+    {
+        for (int jointIdx = 0; jointIdx < static_cast<int>(parents.size()); ++jointIdx)
+        {
+            MFA_ASSERT(parents[jointIdx] < jointIdx);
+        }
+        _parents = std::move(parents);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    std::vector<int> const & TreeSolver::GetParents() const
+    {
+        return _parents;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    std::vector<int> const & TreeSolver::NodeIndices() const
+    {
+        return _nodeIndices;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    int TreeSolver::JointCount() const
+    {
+        return static_cast<int>(_parents.size());
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TreeSolver::WorldMatrices(Chain const & joints, std::vector<glm::mat4> & outMatrices) const
+    {
+        MFA_ASSERT(joints.size() == _parents.size());
+        outMatrices.resize(joints.size());
+        for (size_t jointIdx = 0; jointIdx < joints.size(); ++jointIdx)
+        {
+            auto const parent = _parents[jointIdx];
+            outMatrices[jointIdx] = (parent >= 0 ? outMatrices[parent] : _root) *
+                ForwardKinematic::JointMatrix(joints[jointIdx]);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    TreeSolver::Result TreeSolver::Solve(Chain & joints, std::vector<EndEffector> const & endEffectors)
+    {
+        InverseKinematic::Termination const termination(_params);
+
+        MFA_ASSERT(joints.size() == _parents.size());
+
+        Result result{};
+
+        for (auto & joint : joints)
+        {
+            ClampToLimits(joint);
+        }
+
+        WorldMatrices(joints, _world);
+        BuildPaths(endEffectors);
+        result.error = EvaluateResidual(endEffectors);
+
+        InverseKinematic::AdaptiveDamping damping(_params, _params.damping);
+        bool const isAdaptive = _params.dampingMode != InverseKinematic::DampingMode::Fixed;
+        bool isJacobianCurrent = false;
+
+        for (int iteration = 0; iteration < _params.maxIterations && endEffectors.empty() == false; ++iteration)
+        {
+            if (termination.ShouldStop(result.error) == true)
+            {
+                break;
+            }
+            result.iterations = iteration + 1;
+
+            if (isJacobianCurrent == false)
+            {
+                BuildBlocks(joints, endEffectors);
+                isJacobianCurrent = true;
+            }
+            CalculateStep(isAdaptive ? damping.GetDamping() : _params.damping);
+
+            _previousJoints = joints;
+            _previousWorld = _world;
+            _previousResidual = _residual;
+
+            // Projects the step into the joint limits, _dTheta keeps the applied step
+            for (size_t jointIdx = 0; jointIdx < joints.size(); ++jointIdx)
+            {
+                auto & joint = joints[jointIdx];
+                auto const previous = joint;
+                auto const & step = _dTheta[jointIdx];
+                if (joint.isLengthFixed == false)
+                {
+                    joint.length += step.x;
+                }
+                if (joint.isX_AngleFixed == false)
+                {
+                    joint.angle.x += step.y;
+                }
+                if (joint.isY_AngleFixed == false)
+                {
+                    joint.angle.y += step.z;
+                }
+                ClampToLimits(joint);
+                _dTheta[jointIdx] = glm::vec3 {
+                    joint.length - previous.length,
+                    joint.angle.x - previous.angle.x,
+                    joint.angle.y - previous.angle.y
+                };
+            }
+
+            WorldMatrices(joints, _world);
+            float const error = EvaluateResidual(endEffectors);
+
+            if (isAdaptive == true)
+            {
+                // Residual predicted by the linear model: r - J * dTheta
+                float predictedSquared = 0.0f;
+                for (size_t effectorIdx = 0; effectorIdx < endEffectors.size(); ++effectorIdx)
+                {
+                    Eigen::Vector3f predicted = _previousResidual.segment<3>(effectorIdx * 3);
+                    for (int pathIdx = _pathOffsets[effectorIdx]; pathIdx < _pathOffsets[effectorIdx + 1]; ++pathIdx)
+                    {
+                        auto const & step = _dTheta[_pathJoints[pathIdx]];
+                        predicted -= _blocks[pathIdx] * Eigen::Vector3f{step.x, step.y, step.z};
+                    }
+                    predictedSquared += predicted.squaredNorm();
+                }
+
+                bool const isAccepted = damping.Update(
+                    _previousResidual.squaredNorm(),
+                    _residual.squaredNorm(),
+                    predictedSquared
+                );
+                if (isAccepted == false)
+                {
+                    // The blocks still belong to the restored pose
+                    std::swap(joints, _previousJoints);
+                    std::swap(_world, _previousWorld);
+                    std::swap(_residual, _previousResidual);
+                    continue;
+                }
+            }
+
+            result.error = error;
+            isJacobianCurrent = false;
+        }
+
+        result.converged = result.error <= _params.tolerance;
+        result.elapsedUs = termination.ElapsedUs();
+        return result;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TreeSolver::BuildPaths(std::vector<EndEffector> const & endEffectors)
+    {
+        _pathOffsets.clear();
+        _pathJoints.clear();
+        _pathOffsets.emplace_back(0);
+        for (auto const & endEffector : endEffectors)
+        {
+            MFA_ASSERT(endEffector.joint >= 0 && endEffector.joint < JointCount());
+            for (int joint = endEffector.joint; joint >= 0; joint = _parents[joint])
+            {
+                _pathJoints.emplace_back(joint);
+            }
+            _pathOffsets.emplace_back(static_cast<int>(_pathJoints.size()));
+        }
+        _blocks.resize(_pathJoints.size());
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TreeSolver::BuildBlocks(Chain const & joints, std::vector<EndEffector> const & endEffectors)
+    {
+        // Angles are stored in degree so angular columns are scaled by d(radian)/d(degree)
+        static constexpr float degreeToRadian = glm::pi<float>() / 180.0f;
+
+        for (size_t effectorIdx = 0; effectorIdx < endEffectors.size(); ++effectorIdx)
+        {
+            auto const & endEffector = endEffectors[effectorIdx];
+            glm::vec3 const endPoint = _world[endEffector.joint][3];
+
+            for (int pathIdx = _pathOffsets[effectorIdx]; pathIdx < _pathOffsets[effectorIdx + 1]; ++pathIdx)
+            {
+                auto const jointIdx = _pathJoints[pathIdx];
+                auto const & joint = joints[jointIdx];
+                auto const parentIdx = _parents[jointIdx];
+                glm::mat4 const & parentMatrix = parentIdx >= 0 ? _world[parentIdx] : _root;
+                glm::mat3 const parent = parentMatrix;
+                auto const toEnd = endPoint - glm::vec3(parentMatrix[3]);
+
+                // The x axis is rotated by the y rotation of the same joint
+                float const yRadian = glm::radians(joint.angle.y);
+                glm::vec3 const axisY = parent * Math::UpVec3;
+                glm::vec3 const axisX = parent * glm::vec3{std::cos(yRadian), 0.0f, -std::sin(yRadian)};
+                glm::vec3 const direction = glm::mat3(_world[jointIdx]) * Math::UpVec3;
+
+                glm::vec3 const columns[DOF_PerJoint]
+                {
+                    joint.isLengthFixed ? glm::vec3{} : direction,
+                    joint.isX_AngleFixed ? glm::vec3{} : glm::cross(axisX, toEnd) * degreeToRadian,
+                    joint.isY_AngleFixed ? glm::vec3{} : glm::cross(axisY, toEnd) * degreeToRadian,
+                };
+
+                auto & block = _blocks[pathIdx];
+                for (int dof = 0; dof < DOF_PerJoint; dof++)
+                {
+                    block.col(dof) << columns[dof].x, columns[dof].y, columns[dof].z;
+                }
+                block *= endEffector.weight;
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    float TreeSolver::EvaluateResidual(std::vector<EndEffector> const & endEffectors)
+    {
+        float maxError = 0.0f;
+        _residual.resize(static_cast<Eigen::Index>(endEffectors.size()) * 3);
+        for (size_t effectorIdx = 0; effectorIdx < endEffectors.size(); ++effectorIdx)
+        {
+            auto const & endEffector = endEffectors[effectorIdx];
+            auto const error = endEffector.target - glm::vec3(_world[endEffector.joint][3]);
+            maxError = std::max(maxError, glm::length(error));
+            _residual.segment<3>(effectorIdx * 3) << error.x * endEffector.weight,
+                error.y * endEffector.weight,
+                error.z * endEffector.weight;
+        }
+        return maxError;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TreeSolver::CalculateStep(float const damping)
+    {
+        // dTheta = JT * (J * JT + damping * I)^-1 * r, with J * JT built block by block. Block (a, b) only sums over
+        // the joints shared by the paths of both end effectors.
+        auto const effectorCount = static_cast<int>(_pathOffsets.size()) - 1;
+        _JxJT.setZero(effectorCount * 3, effectorCount * 3);
+
+        for (int a = 0; a < effectorCount; ++a)
+        {
+            for (int b = a; b < effectorCount; ++b)
+            {
+                // Paths go from the end effector to the root so joint indices are decreasing
+                Eigen::Matrix3f sum = Eigen::Matrix3f::Zero();
+                int pathA = _pathOffsets[a];
+                int pathB = _pathOffsets[b];
+                while (pathA < _pathOffsets[a + 1] && pathB < _pathOffsets[b + 1])
+                {
+                    auto const jointA = _pathJoints[pathA];
+                    auto const jointB = _pathJoints[pathB];
+                    if (jointA == jointB)
+                    {
+                        sum.noalias() += _blocks[pathA] * _blocks[pathB].transpose();
+                        ++pathA;
+                        ++pathB;
+                    }
+                    else if (jointA > jointB)
+                    {
+                        ++pathA;
+                    }
+                    else
+                    {
+                        ++pathB;
+                    }
+                }
+                _JxJT.block<3, 3>(a * 3, b * 3) = sum;
+                _JxJT.block<3, 3>(b * 3, a * 3) = sum.transpose();
+            }
+        }
+        _JxJT.diagonal().array() += damping;
+
+        _ldlt.compute(_JxJT);
+        _y = _ldlt.solve(_residual);
+
+        _dTheta.assign(_parents.size(), glm::vec3{});
+        for (int effectorIdx = 0; effectorIdx < effectorCount; ++effectorIdx)
+        {
+            Eigen::Vector3f const y = _y.segment<3>(effectorIdx * 3);
+            for (int pathIdx = _pathOffsets[effectorIdx]; pathIdx < _pathOffsets[effectorIdx + 1]; ++pathIdx)
+            {
+                Eigen::Vector3f const step = _blocks[pathIdx].transpose() * y;
+                _dTheta[_pathJoints[pathIdx]] += glm::vec3{step.x(), step.y(), step.z()};
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    void TreeSolver::SetParams(InverseKinematic::Params const & params)
+    {
+        _params = params;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Params const & TreeSolver::GetParams() const
+    {
+        return _params;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "InverseKinematic.hpp"
+
+#include <Eigen>
+
+namespace Shared
+{
+
+    // Damped least squares for a branching hierarchy with several end effectors that share ancestor joints,
+    // for example a spine feeding two arms. Joint i hangs from joint parents[i] (or from the root when it is -1).
+    // The stacked jacobian is stored as 3x3 blocks, one per (end effector, ancestor joint) pair, so the
+    // structurally zero blocks of joints on other branches are never built or multiplied.
+    // Not thread safe, every thread should own its solver.
+    class TreeSolver
+    {
+    public:
+
+        struct EndEffector
+        {
+            int joint = -1;                 // The end point of this joint is driven toward the target
+            glm::vec3 target {};
+            float weight = 1.0f;
+        };
+
+        struct Result
+        {
+            float error {};                 // Largest distance between an end effector and its target
+            int iterations {};
+            bool converged = false;
+            float elapsedUs {};
+        };
+
+        // Uses damping, dampingMode, minDamping, maxDamping, maxIterations, tolerance and timeBudgetUs.
+        // Selective damping is not supported by the block solver and behaves like Adaptive.
+        explicit TreeSolver(InverseKinematic::Params const & params);
+
+        // Parents have to come before their children (parents[i] < i)
+        void SetTopology(std::vector<int> parents);
+
+        // Builds the topology from glTF style nodes with parent and children indices, such as
+        // MFA::Asset::GLTF::Node. Joints are ordered breadth first from the root nodes, NodeIndices maps every
+        // joint back to its node.
+        template<typename Node>
+        void SetTopologyFromNodes(std::vector<Node> const & nodes)
+        {
+            std::vector<int> nodeIndices{};
+            nodeIndices.reserve(nodes.size());
+            for (int nodeIdx = 0; nodeIdx < static_cast<int>(nodes.size()); ++nodeIdx)
+            {
+                if (nodes[nodeIdx].parent < 0)
+                {
+                    nodeIndices.emplace_back(nodeIdx);
+                }
+            }
+
+            std::vector<int> jointOfNode(nodes.size(), -1);
+            std::vector<int> parents{};
+            parents.reserve(nodes.size());
+            for (size_t jointIdx = 0; jointIdx < nodeIndices.size(); ++jointIdx)
+            {
+                auto const & node = nodes[nodeIndices[jointIdx]];
+                jointOfNode[nodeIndices[jointIdx]] = static_cast<int>(jointIdx);
+                parents.emplace_back(node.parent >= 0 ? jointOfNode[node.parent] : -1);
+                for (int const child : node.children)
+                {
+                    nodeIndices.emplace_back(child);
+                }
+            }
+
+            _nodeIndices = std::move(nodeIndices);
+            SetTopology(std::move(parents));
+        }
+
+        [[nodiscard]]
+        std::vector<int> const & GetParents() const;
+
+        // Node index of every joint when the topology came from SetTopologyFromNodes
+        [[nodiscard]]
+        std::vector<int> const & NodeIndices() const;
+
+        [[nodiscard]]
+        int JointCount() const;
+
+        // Modifies the joints in place so that every end effector moves toward its target
+        Result Solve(Chain & joints, std::vector<EndEffector> const & endEffectors);
+
+        // World matrix of every joint for the current topology
+        void WorldMatrices(Chain const & joints, std::vector<glm::mat4> & outMatrices) const;
+
+        void SetParams(InverseKinematic::Params const & params);
+
+        [[nodiscard]]
+        InverseKinematic::Params const & GetParams() const;
+
+    private:
+
+        void BuildPaths(std::vector<EndEffector> const & endEffectors);
+
+        void BuildBlocks(Chain const & joints, std::vector<EndEffector> const & endEffectors);
+
+        // Residual of every end effector into _residual, returns the largest unweighted distance
+        float EvaluateResidual(std::vector<EndEffector> const & endEffectors);
+
+        void CalculateStep(float damping);
+
+        InverseKinematic::Params _params{};
+        std::vector<int> _parents{};
+        std::vector<int> _nodeIndices{};
+
+        glm::mat4 _root{};
+        std::vector<glm::mat4> _world{};
+
+        // Ancestor path of every end effector (self first, then toward the root) and the jacobian block of each
+        // path element. Paths of end effector e are [_pathOffsets[e], _pathOffsets[e + 1]).
+        std::vector<int> _pathOffsets{};
+        std::vector<int> _pathJoints{};
+        std::vector<Eigen::Matrix3f> _blocks{};
+
+        // State before the last step, restored when the adaptive damping rejects it
+        Chain _previousJoints{};
+        std::vector<glm::mat4> _previousWorld{};
+        Eigen::VectorX<float> _previousResidual{};
+
+        Eigen::VectorX<float> _residual{};
+        Eigen::MatrixX<float> _JxJT{};
+        Eigen::LDLT<Eigen::MatrixX<float>> _ldlt{};
+        Eigen::VectorX<float> _y{};
+        std::vector<glm::vec3> _dTheta{};
+
+    };
+
+}
@@ -0,0 +1,115 @@
+#include "TwoBoneSolver.hpp"
+
+#include "ForwardKinematic.hpp"
+
+#include "BedrockAssert.hpp"
+#include "BedrockMath.hpp"
+
+namespace Shared::TwoBoneSolver
+{
+
+    using namespace MFA;
+
+    //-------------------------------------------------------------------------------------------------
+
+    bool CanSolve(Chain const & chain)
+    {
+        if (chain.size() != 2)
+        {
+            return false;
+        }
+        for (auto const & joint : chain)
+        {
+            if (ActiveDOF_Mask(joint) != (X_AngleBit | Y_AngleBit) || HasLimits(joint) == true)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    InverseKinematic::Result Solve(Chain & chain, glm::vec3 const & target, glm::vec3 const * pole)
+    {
+        MFA_ASSERT(chain.size() == 2);
+
+        InverseKinematic::Result result{};
+        result.iterations = 1;
+
+        auto & upper = chain[0];
+        auto & lower = chain[1];
+
+        glm::mat3 const rootRotation = ForwardKinematic::RootMatrix();
+        glm::vec3 const root {};
+
+        float const upperLength = std::abs(upper.length);
+        float const lowerLength = std::abs(lower.length);
+
+        // Clamp the distance to the reachable range
+        auto toTarget = target - root;
+        float const targetDistance = glm::length(toTarget);
+        float const minDistance = std::abs(upperLength - lowerLength);
+        float const maxDistance = upperLength + lowerLength;
+        float const distance = std::clamp(targetDistance, minDistance, maxDistance);
+
+        if (upperLength <= glm::epsilon<float>() || lowerLength <= glm::epsilon<float>())
+        {
+            result.endPoint = ForwardKinematic::Calculate(chain);
+            result.error = glm::length(target - result.endPoint);
+            return result;
+        }
+
+        glm::vec3 const currentElbow = rootRotation * (ForwardKinematic::JointRotation(upper) * Math::UpVec3) * upper.length;
+        glm::vec3 const targetDirection = targetDistance > glm::epsilon<float>()
+            ? toTarget / targetDistance
+            : glm::normalize(rootRotation * Math::UpVec3);
+
+        // Bend direction: part of the pole that is perpendicular to the target direction
+        auto const perpendicular = [&targetDirection](glm::vec3 const & point)->glm::vec3
+        {
+            return point - targetDirection * glm::dot(point, targetDirection);
+        };
+        glm::vec3 bendDirection = pole != nullptr ? perpendicular(*pole - root) : glm::vec3{};
+        if (Math::IsNearZero(bendDirection))
+        {
+            bendDirection = perpendicular(currentElbow);
+        }
+        if (Math::IsNearZero(bendDirection))
+        {
+            // Straight chain toward the target, any perpendicular axis works
+            bendDirection = perpendicular(std::abs(targetDirection.x) < 0.9f ? Math::RightVec3 : Math::ForwardVec3);
+        }
+        bendDirection = glm::normalize(bendDirection);
+
+        // Law of cosines for the angle between the upper bone and the target direction
+        float const cosUpper = (upperLength * upperLength + distance * distance - lowerLength * lowerLength) /
+            (2.0f * upperLength * distance);
+        float const upperAngle = Math::ACosSafe(cosUpper);
+
+        glm::vec3 const upperDirection = targetDirection * std::cos(upperAngle) + bendDirection * std::sin(upperAngle);
+        glm::vec3 const elbow = root + upperDirection * upperLength;
+        glm::vec3 const wrist = root + targetDirection * distance;
+        glm::vec3 const lowerDirection = glm::normalize(wrist - elbow);
+
+        // Convert the world space bone directions back to joint angles
+        float const upperSign = upper.length < 0.0f ? -1.0f : 1.0f;
+        float const lowerSign = lower.length < 0.0f ? -1.0f : 1.0f;
+        upper.angle = ForwardKinematic::AnglesFromDirection(
+            glm::transpose(rootRotation) * upperDirection * upperSign,
+            upper.angle
+        );
+        glm::mat3 const upperRotation = rootRotation * ForwardKinematic::JointRotation(upper);
+        lower.angle = ForwardKinematic::AnglesFromDirection(
+            glm::transpose(upperRotation) * lowerDirection * lowerSign,
+            lower.angle
+        );
+
+        result.endPoint = ForwardKinematic::Calculate(chain);
+        result.error = glm::length(target - result.endPoint);
+        return result;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+}
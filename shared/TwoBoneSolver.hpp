@@ -0,0 +1,17 @@
+#pragma once
+
+#include "InverseKinematic.hpp"
+
+namespace Shared::TwoBoneSolver
+{
+
+    // True if the chain has exactly two joints with fixed lengths and free, unlimited x, y angles (the common limb case)
+    [[nodiscard]]
+    bool CanSolve(Chain const & chain);
+
+    // Closed form law of cosines solution. The elbow is placed on the plane that contains the root, the target and
+    // the pole. Without a pole (or with a pole on the root-target line) the current elbow position is used as pole
+    // so the pose stays continuous between frames. Unreachable targets are clamped to the reachable range.
+    InverseKinematic::Result Solve(Chain & chain, glm::vec3 const & target, glm::vec3 const * pole = nullptr);
+
+}